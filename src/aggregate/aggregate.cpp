@@ -0,0 +1,377 @@
+/**
+ * @file aggregate.cpp
+ * @author Daria Tiurina (tiuridar@fit.cvut.cz)
+ * @brief Implementation of kernels of aggregate functions, of ColumnIndex and of NumberColumn. Kernels process four numbers at once with AVX2, if processor supports it, otherwise two with SSE2
+ * @version 1.0
+ * @date 2023-06-05
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+#ifndef AGGREGATE_CPP
+#define AGGREGATE_CPP
+#include "aggregate.h"
+#include <algorithm>
+#include <limits>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define AGGREGATE_AVX2
+#include <immintrin.h>
+#endif
+
+#ifdef AGGREGATE_AVX2
+/**
+ * @brief Helping function, which detects if processor supports AVX2. Program is compiled without it, so AVX2 kernels are chosen while running
+ *
+ * @return true AVX2 kernels can be used
+ * @return false only SSE2 kernels can be used
+ */
+static bool hasAvx2()
+{
+    static const bool ret = __builtin_cpu_supports("avx2");
+    return ret;
+}
+
+/**
+ * @brief Sum of numbers with AVX2
+ *
+ * @param data numbers one after another
+ * @param size number of numbers
+ * @return double sum, 0 if there are no numbers
+ */
+__attribute__((target("avx2"))) static double sumAvx2(const double *data, const size_t &size)
+{
+    size_t i = 0;
+    __m256d acc1 = _mm256_setzero_pd();
+    __m256d acc2 = _mm256_setzero_pd();
+    for (; i + 8 <= size; i += 8)
+    {
+        acc1 = _mm256_add_pd(acc1, _mm256_loadu_pd(data + i));
+        acc2 = _mm256_add_pd(acc2, _mm256_loadu_pd(data + i + 4));
+    }
+    double part[4];
+    _mm256_storeu_pd(part, _mm256_add_pd(acc1, acc2));
+    double ret = (part[0] + part[1]) + (part[2] + part[3]);
+    for (; i < size; i++)
+        ret += data[i];
+    return ret;
+}
+
+/**
+ * @brief Minimum of numbers with AVX2
+ *
+ * @param data numbers one after another
+ * @param size number of numbers, at least 4
+ * @return double the smallest number
+ */
+__attribute__((target("avx2"))) static double minAvx2(const double *data, const size_t &size)
+{
+    size_t i = 4;
+    __m256d acc = _mm256_loadu_pd(data);
+    for (; i + 4 <= size; i += 4)
+        acc = _mm256_min_pd(acc, _mm256_loadu_pd(data + i));
+    double part[4];
+    _mm256_storeu_pd(part, acc);
+    double ret = std::min(std::min(part[0], part[1]), std::min(part[2], part[3]));
+    for (; i < size; i++)
+        ret = std::min(ret, data[i]);
+    return ret;
+}
+
+/**
+ * @brief Maximum of numbers with AVX2
+ *
+ * @param data numbers one after another
+ * @param size number of numbers, at least 4
+ * @return double the biggest number
+ */
+__attribute__((target("avx2"))) static double maxAvx2(const double *data, const size_t &size)
+{
+    size_t i = 4;
+    __m256d acc = _mm256_loadu_pd(data);
+    for (; i + 4 <= size; i += 4)
+        acc = _mm256_max_pd(acc, _mm256_loadu_pd(data + i));
+    double part[4];
+    _mm256_storeu_pd(part, acc);
+    double ret = std::max(std::max(part[0], part[1]), std::max(part[2], part[3]));
+    for (; i < size; i++)
+        ret = std::max(ret, data[i]);
+    return ret;
+}
+#endif
+
+double sumKernel(const double *data, const size_t &size)
+{
+#ifdef AGGREGATE_AVX2
+    if (hasAvx2())
+        return sumAvx2(data, size);
+#endif
+    size_t i = 0;
+    double ret = 0;
+#ifdef __SSE2__
+    //Two accumulators, so additions don't wait for each other
+    __m128d acc1 = _mm_setzero_pd();
+    __m128d acc2 = _mm_setzero_pd();
+    for (; i + 4 <= size; i += 4)
+    {
+        acc1 = _mm_add_pd(acc1, _mm_loadu_pd(data + i));
+        acc2 = _mm_add_pd(acc2, _mm_loadu_pd(data + i + 2));
+    }
+    double part[2];
+    _mm_storeu_pd(part, _mm_add_pd(acc1, acc2));
+    ret = part[0] + part[1];
+#endif
+    for (; i < size; i++)
+        ret += data[i];
+    return ret;
+}
+
+double minKernel(const double *data, const size_t &size)
+{
+#ifdef AGGREGATE_AVX2
+    if (size >= 4 && hasAvx2())
+        return minAvx2(data, size);
+#endif
+    size_t i = 0;
+    double ret = data[0];
+#ifdef __SSE2__
+    if (size >= 2)
+    {
+        __m128d acc = _mm_loadu_pd(data);
+        for (i = 2; i + 2 <= size; i += 2)
+            acc = _mm_min_pd(acc, _mm_loadu_pd(data + i));
+        double part[2];
+        _mm_storeu_pd(part, acc);
+        ret = std::min(part[0], part[1]);
+    }
+#endif
+    for (; i < size; i++)
+        ret = std::min(ret, data[i]);
+    return ret;
+}
+
+double maxKernel(const double *data, const size_t &size)
+{
+#ifdef AGGREGATE_AVX2
+    if (size >= 4 && hasAvx2())
+        return maxAvx2(data, size);
+#endif
+    size_t i = 0;
+    double ret = data[0];
+#ifdef __SSE2__
+    if (size >= 2)
+    {
+        __m128d acc = _mm_loadu_pd(data);
+        for (i = 2; i + 2 <= size; i += 2)
+            acc = _mm_max_pd(acc, _mm_loadu_pd(data + i));
+        double part[2];
+        _mm_storeu_pd(part, acc);
+        ret = std::max(part[0], part[1]);
+    }
+#endif
+    for (; i < size; i++)
+        ret = std::max(ret, data[i]);
+    return ret;
+}
+
+Aggregate::Aggregate() : min(std::numeric_limits<double>::infinity()), max(-std::numeric_limits<double>::infinity()) {}
+
+void Aggregate::add(const Aggregate &src)
+{
+    sum += src.sum;
+    min = std::min(min, src.min);
+    max = std::max(max, src.max);
+    count += src.count;
+    errors += src.errors;
+}
+
+NumberColumn::NumberColumn() {}
+
+NumberColumn::NumberColumn(const NumberColumn &src) : m_Blocks(src.m_Blocks.size())
+{
+    for (size_t i = 0; i < src.m_Blocks.size(); i++)
+        if (src.m_Blocks[i] != nullptr)
+            m_Blocks[i] = std::make_unique<Block>(*src.m_Blocks[i]);
+}
+
+void NumberColumn::set(const size_t &row, const Value &value)
+{
+    size_t block = row / BLOCK_ROWS;
+    bool saved = value.getType() == ValueType::NUMBER || value.getType() == ValueType::ERROR;
+    if (block >= m_Blocks.size() || m_Blocks[block] == nullptr)
+    {
+        if (!saved)
+            return;
+        if (block >= m_Blocks.size())
+            m_Blocks.resize(block + 1);
+        m_Blocks[block] = std::make_unique<Block>();
+    }
+    Block &dest = *m_Blocks[block];
+    uint64_t bit = (uint64_t)1 << (row % BLOCK_ROWS);
+    dest.isNumber &= ~bit;
+    dest.isError &= ~bit;
+    dest.numbers[row % BLOCK_ROWS] = 0;
+    if (value.getType() == ValueType::NUMBER)
+    {
+        dest.isNumber |= bit;
+        dest.numbers[row % BLOCK_ROWS] = value.getNumber();
+    }
+    else if (value.getType() == ValueType::ERROR)
+        dest.isError |= bit;
+    else if (dest.isNumber == 0 && dest.isError == 0)
+        m_Blocks[block] = nullptr;
+}
+
+bool NumberColumn::isNumber(const size_t &row) const
+{
+    size_t block = row / BLOCK_ROWS;
+    return block < m_Blocks.size() && m_Blocks[block] != nullptr && (m_Blocks[block]->isNumber >> (row % BLOCK_ROWS) & 1) != 0;
+}
+
+double NumberColumn::getNumber(const size_t &row) const
+{
+    size_t block = row / BLOCK_ROWS;
+    if (block >= m_Blocks.size() || m_Blocks[block] == nullptr)
+        return 0;
+    return m_Blocks[block]->numbers[row % BLOCK_ROWS];
+}
+
+Aggregate NumberColumn::aggregate(const size_t &from, const size_t &to, const bool &extremes) const
+{
+    Aggregate ret;
+    if (to < from)
+        return ret;
+    size_t lastBlock = std::min(to / BLOCK_ROWS + 1, m_Blocks.size());
+    for (size_t i = from / BLOCK_ROWS; i < lastBlock; i++)
+    {
+        //Missing block is empty
+        if (m_Blocks[i] == nullptr)
+            continue;
+        const Block &src = *m_Blocks[i];
+        size_t first = i == from / BLOCK_ROWS ? from % BLOCK_ROWS : 0;
+        size_t last = i == to / BLOCK_ROWS ? to % BLOCK_ROWS : BLOCK_ROWS - 1;
+        size_t size = last - first + 1;
+        uint64_t mask = (size == BLOCK_ROWS ? ~(uint64_t)0 : (((uint64_t)1 << size) - 1)) << first;
+        uint64_t numbers = src.isNumber & mask;
+        Aggregate part;
+        part.count = (size_t)__builtin_popcountll(numbers);
+        part.errors = (size_t)__builtin_popcountll(src.isError & mask);
+        //Rows without a number have 0 saved, so they don't change a sum
+        part.sum = sumKernel(src.numbers + first, size);
+        if (extremes && part.count == size)
+        {
+            part.min = minKernel(src.numbers + first, size);
+            part.max = maxKernel(src.numbers + first, size);
+        }
+        else if (extremes && part.count != 0)
+        {
+            double found[BLOCK_ROWS];
+            size_t count = 0;
+            for (; numbers != 0; numbers &= numbers - 1)
+                found[count++] = src.numbers[__builtin_ctzll(numbers)];
+            part.min = minKernel(found, count);
+            part.max = maxKernel(found, count);
+        }
+        ret.add(part);
+    }
+    return ret;
+}
+
+size_t NumberColumn::getBlocks() const
+{
+    return m_Blocks.size();
+}
+
+ColumnIndex::ColumnIndex() : m_Size(1), m_Nodes(1) {}
+
+ColumnIndex::ColumnIndex(const NumberColumn &column) : m_Size(1), m_Nodes(1)
+{
+    //Empty blocks are not saved, so only blocks with numbers or errors make nodes
+    for (size_t i = 0; i < column.getBlocks(); i++)
+        this->set(i, column.aggregate(i * NumberColumn::BLOCK_ROWS, (i + 1) * NumberColumn::BLOCK_ROWS - 1, true));
+}
+
+void ColumnIndex::set(const size_t &block, const Aggregate &value)
+{
+    bool empty = value.count == 0 && value.errors == 0;
+    if (block >= m_Size && empty)
+        return;
+    while (block >= m_Size)
+    {
+        //Old root becomes left child of a new root
+        m_Nodes.push_back(m_Nodes[0]);
+        m_Nodes[0].children[0] = m_Nodes.size() - 1;
+        m_Nodes[0].children[1] = 0;
+        m_Size *= 2;
+    }
+
+    std::vector<size_t> path;
+    size_t node = 0;
+    size_t begin = 0;
+    for (size_t size = m_Size; size > 1;)
+    {
+        path.push_back(node);
+        size /= 2;
+        size_t side = block >= begin + size ? 1 : 0;
+        begin += side * size;
+        if (m_Nodes[node].children[side] == 0)
+        {
+            if (empty)
+                return;
+            m_Nodes.push_back(Node());
+            m_Nodes[node].children[side] = m_Nodes.size() - 1;
+        }
+        node = m_Nodes[node].children[side];
+    }
+    m_Nodes[node].value = value;
+    for (size_t i = path.size(); i > 0; i--)
+    {
+        Node &parent = m_Nodes[path[i - 1]];
+        parent.value = Aggregate();
+        for (size_t child : parent.children)
+            if (child != 0)
+                parent.value.add(m_Nodes[child].value);
+    }
+}
+
+void ColumnIndex::update(const size_t &row, const NumberColumn &column)
+{
+    size_t block = row / NumberColumn::BLOCK_ROWS;
+    this->set(block, column.aggregate(block * NumberColumn::BLOCK_ROWS, (block + 1) * NumberColumn::BLOCK_ROWS - 1, true));
+}
+
+void ColumnIndex::query(const size_t &node, const size_t &begin, const size_t &size, const size_t &from, const size_t &to, Aggregate &ret) const
+{
+    if (to < begin || from >= begin + size)
+        return;
+    if (from <= begin && begin + size - 1 <= to)
+    {
+        ret.add(m_Nodes[node].value);
+        return;
+    }
+    for (size_t i = 0; i < 2; i++)
+        if (m_Nodes[node].children[i] != 0)
+            this->query(m_Nodes[node].children[i], begin + i * size / 2, size / 2, from, to, ret);
+}
+
+Aggregate ColumnIndex::query(const size_t &from, const size_t &to, const NumberColumn &column) const
+{
+    const size_t &rows = NumberColumn::BLOCK_ROWS;
+    if (to < from || from / rows == to / rows)
+        return column.aggregate(from, to, true);
+    Aggregate ret;
+    size_t first = from / rows;
+    size_t last = to / rows;
+    //Parts of blocks at the ends are read from a column
+    if (from % rows != 0)
+        ret.add(column.aggregate(from, ++first * rows - 1, true));
+    if (to % rows != rows - 1)
+        ret.add(column.aggregate(last-- * rows, to, true));
+    if (first <= last)
+        this->query(0, 0, m_Size, first, last, ret);
+    return ret;
+}
+
+#endif // AGGREGATE_CPP
@@ -0,0 +1,237 @@
+/**
+ * @file aggregate.h
+ * @author Daria Tiurina (tiuridar@fit.cvut.cz)
+ * @brief Declaration of kernels of aggregate functions over numbers, of an index of a column and of a column of numbers
+ * @version 1.0
+ * @date 2023-06-05
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+#ifndef AGGREGATE_H
+#define AGGREGATE_H
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <memory>
+#include "../value/value.h"
+
+/**
+ * @brief Sum of numbers
+ *
+ * @param data numbers one after another
+ * @param size number of numbers
+ * @return double sum, 0 if there are no numbers
+ */
+double sumKernel(const double *data, const size_t &size);
+
+/**
+ * @brief Minimum of numbers
+ *
+ * @param data numbers one after another
+ * @param size number of numbers, at least 1
+ * @return double the smallest number
+ */
+double minKernel(const double *data, const size_t &size);
+
+/**
+ * @brief Maximum of numbers
+ *
+ * @param data numbers one after another
+ * @param size number of numbers, at least 1
+ * @return double the biggest number
+ */
+double maxKernel(const double *data, const size_t &size);
+
+/**
+ * @brief Aggregated numbers of a part of a column
+ *
+ */
+struct Aggregate
+{
+    //!> sum of numbers
+    double sum = 0;
+
+    //!> the smallest number, +infinity if there are no numbers
+    double min;
+
+    //!> the biggest number, -infinity if there are no numbers
+    double max;
+
+    //!> number of numbers
+    size_t count = 0;
+
+    //!> number of errors
+    size_t errors = 0;
+
+    /**
+     * @brief Construct a new empty Aggregate object
+     */
+    Aggregate();
+
+    /**
+     * @brief Adds another part of a column
+     * @param src aggregated numbers of another part
+     */
+    void add(const Aggregate &src);
+};
+
+/**
+ * @brief Class NumberColumn, numbers of one column of a table saved one after another in blocks of rows. Type of every Cell is saved in bitmaps, so column is read without Cells. Block without numbers and errors is not allocated
+ *
+ */
+class NumberColumn
+{
+public:
+    /**
+     * @brief Construct a new empty NumberColumn object
+     */
+    NumberColumn();
+
+    /**
+     * @brief Construct a new NumberColumn object copied from a source NumberColumn
+     * @param src NumberColumn which needs to be copied
+     */
+    NumberColumn(const NumberColumn &src);
+
+    /**
+     * @brief Saves new Value of a Cell
+     *
+     * @param row row, where Cell is situated
+     * @param value Value of a Cell, only numbers and errors are saved
+     */
+    void set(const size_t &row, const Value &value);
+
+    /**
+     * @brief Detects if Cell has a number
+     *
+     * @param row row, where Cell is situated
+     * @return true Cell has a number
+     * @return false Cell is empty or has a line or an error
+     */
+    bool isNumber(const size_t &row) const;
+
+    /**
+     * @brief Get the number of a Cell
+     *
+     * @param row row, where Cell is situated
+     * @return double number, 0 if Cell doesn't have a number
+     */
+    double getNumber(const size_t &row) const;
+
+    /**
+     * @brief Aggregates numbers in rows with kernels, every block is aggregated separately
+     *
+     * @param from first row
+     * @param to last row (included)
+     * @param extremes true if minimum and maximum are needed
+     * @return Aggregate aggregated numbers
+     */
+    Aggregate aggregate(const size_t &from, const size_t &to, const bool &extremes) const;
+
+    /**
+     * @brief Get the number of blocks, empty blocks after last not empty block are not counted
+     * @return size_t number of blocks
+     */
+    size_t getBlocks() const;
+
+    //!> number of rows in one block, same as number of Lines in one block of a table
+    static constexpr size_t BLOCK_ROWS = 64;
+
+private:
+    /**
+     * @brief Numbers and types of Cells of one block of rows
+     */
+    struct Block
+    {
+        //!> numbers of Cells, 0 if Cell doesn't have a number
+        double numbers[BLOCK_ROWS] = {};
+
+        //!> bit for every row, set if Cell has a number
+        uint64_t isNumber = 0;
+
+        //!> bit for every row, set if Cell has an error
+        uint64_t isError = 0;
+    };
+
+    //!> blocks of rows, not allocated block is nullptr
+    std::vector<std::unique_ptr<Block>> m_Blocks;
+};
+
+/**
+ * @brief Class ColumnIndex, segment tree over blocks of rows of one NumberColumn. Nodes are made only for blocks with numbers or errors, so far rows don't allocate the whole tree. Change of one Cell and aggregate over rows are O(log n)
+ *
+ */
+class ColumnIndex
+{
+public:
+    /**
+     * @brief Construct a new empty ColumnIndex object
+     */
+    ColumnIndex();
+
+    /**
+     * @brief Construct a new ColumnIndex object over all blocks of a column
+     * @param column column of numbers
+     */
+    ColumnIndex(const NumberColumn &column);
+
+    /**
+     * @brief Counts again a block of a changed Cell
+     *
+     * @param row row, where Cell is situated
+     * @param column column of numbers, which already has a new Value of a Cell
+     */
+    void update(const size_t &row, const NumberColumn &column);
+
+    /**
+     * @brief Aggregates numbers in rows. Whole blocks are read from a tree, parts of blocks at the ends of rows are read from a column
+     *
+     * @param from first row
+     * @param to last row (included)
+     * @param column column of numbers, which is indexed
+     * @return Aggregate aggregated numbers
+     */
+    Aggregate query(const size_t &from, const size_t &to, const NumberColumn &column) const;
+
+private:
+    /**
+     * @brief Node of a tree, aggregated numbers of its blocks
+     */
+    struct Node
+    {
+        //!> aggregated numbers of all blocks under a node
+        Aggregate value;
+
+        //!> indexes of left and right child in m_Nodes, 0 if child is not made
+        size_t children[2] = {0, 0};
+    };
+
+    //!> number of blocks, which tree can hold, power of 2
+    size_t m_Size;
+
+    //!> nodes of a tree, m_Nodes[0] is a root
+    std::vector<Node> m_Nodes;
+
+    /**
+     * @brief Saves aggregated numbers of one block
+     *
+     * @param block index of a block
+     * @param value aggregated numbers of a block
+     */
+    void set(const size_t &block, const Aggregate &value);
+
+    /**
+     * @brief Adds aggregated numbers of blocks under a node, which are in a range of blocks
+     *
+     * @param node index of a node
+     * @param begin first block under a node
+     * @param size number of blocks under a node
+     * @param from first block of a range
+     * @param to last block of a range (included)
+     * @param ret aggregated numbers, to which blocks are added
+     */
+    void query(const size_t &node, const size_t &begin, const size_t &size, const size_t &from, const size_t &to, Aggregate &ret) const;
+};
+
+#endif // AGGREGATE_H
@@ -1,9 +1,9 @@
 /**
  * @file cell.cpp
  * @author Daria Tiurina (tiuridar@fit.cvut.cz)
- * @brief Implementation of a Cell, NumCell and StringCell
- * @version 0.9
- * @date 2023-05-12
+ * @brief Implementation of a Cell
+ * @version 1.0
+ * @date 2023-06-05
  *
  * @copyright Copyright (c) 2023
  *
@@ -12,28 +12,25 @@
 #define CELL_CPP
 #include "cell.h"
 #include "../help/help.h"
-#include "../operators/operators.h"
-#include <cmath>
-#include <sstream>
+#include <algorithm>
 
-Cell::Cell() {}
+Cell::Cell() : m_Type(CellType::EMPTY), m_Formula(-1), m_Inside() {}
 
 Cell::~Cell() {}
 
-void Cell::setInside(const std::string &src)
+CellType Cell::getType() const
 {
-    std::string copy = src;
-    return;
+    return m_Type;
 }
 
-void Cell::print(std::ostream &os) const
+bool Cell::isEmpty() const
 {
-    os << "";
+    return m_Type == CellType::EMPTY;
 }
 
-void Cell::printFunc(std::ostream &os) const
+void Cell::print(std::ostream &os) const
 {
-    os << "";
+    m_Inside.print(os);
 }
 
 std::ostream &operator<<(std::ostream &os, const Cell &src)
@@ -44,303 +41,127 @@ std::ostream &operator<<(std::ostream &os, const Cell &src)
 
 size_t Cell::getLength() const
 {
-    return 0; //!< Cell is default empty Cell => lentgh is 0
+    if (m_Type == CellType::EMPTY)
+        return 0; //!< empty Cell => lentgh is 0
+    return m_Inside.getLength();
 }
 
-std::vector<std::string> Cell::getFormula() const
+const Value &Cell::getValue() const
 {
-    return std::vector<std::string>();
+    return m_Inside;
 }
 
-std::string Cell::whatIs() const
+void Cell::setNumber(const double &newValue)
 {
-    return "Cell";
+    m_Type = CellType::NUMBER;
+    m_Formula = -1;
+    m_Inside = Value(newValue);
 }
 
-std::string Cell::operation(const std::string &operation, const std::string &operand, const bool &isFirst) const
+void Cell::setString(const std::string &newValue)
 {
-    return operation + operand + std::to_string(isFirst);
+    m_Type = CellType::STRING;
+    m_Formula = -1;
+    m_Inside = Value(newValue);
 }
 
-std::string Cell::function(const std::string &operation) const
+void Cell::setFormula(const int &index)
 {
-    return operation;
+    m_Type = CellType::FORMULA;
+    m_Formula = index;
+    m_Inside = Value();
 }
 
-NumCell::NumCell() : Cell(), m_Inside(0) {}
-
-NumCell::NumCell(const NumCell &src) : Cell(), m_Inside(src.m_Inside) {}
-
-NumCell::NumCell(const int &src) : Cell(), m_Inside(src) {}
-
-NumCell::~NumCell() {}
-
-size_t NumCell::getLength() const
+int Cell::getFormula() const
 {
-    double intpart, fpart;
-    fpart = modf(m_Inside, &intpart);
-    long int intp = (long int)intpart;
-    if (fpart != 0)
-        return (std::to_string(intp) + std::to_string(fpart)).length() - 1;
-
-    return std::to_string(intp).length();
+    return m_Formula;
 }
 
-double NumCell::getValue()
+void Cell::setInside(const Value &src)
 {
-    return m_Inside;
+    m_Inside = src;
 }
 
-void NumCell::print(std::ostream &os) const
+void Cell::clear()
 {
-    double intpart, fpart;
-    fpart = modf(m_Inside, &intpart);
-    if (fpart != 0)
-    {
-        os << m_Inside;
-    }
-    else
-    {
-        long int intp = (long int)intpart;
-        os << intp;
-    }
+    m_Type = CellType::EMPTY;
+    m_Formula = -1;
+    m_Inside = Value();
 }
 
-void NumCell::setValue(const double &newValue)
+Value Cell::operation(const OpCode &operation, const Value &operand, const bool &isFirst) const
 {
-    m_Inside = newValue;
+    if (isFirst)
+        return m_Inside.operation(operation, operand);
+    return operand.operation(operation, m_Inside);
 }
 
-std::string NumCell::whatIs() const
+Value Cell::function(const OpCode &operation) const
 {
-    return "NumCell";
+    return m_Inside.function(operation);
 }
 
-std::string NumCell::operation(const std::string &operation, const std::string &operand, const bool &isFirst) const
-{
-    std::string ret;
-    if (isNum(operand))
-    {
-        double num = std::stod(operand);
-        if (operation == "+")
-            ret = std::to_string(num + m_Inside);
-        else if (operation == "-" && isFirst)
-            ret = std::to_string(m_Inside - num);
-        else if (operation == "-" && !isFirst)
-            ret = std::to_string(num - m_Inside);
-        else if (operation == "*")
-            ret = std::to_string(num * m_Inside);
-        else if (operation == "/" && isFirst)
-            ret = std::to_string(m_Inside / num);
-        else if (operation == "/" && !isFirst)
-            ret = std::to_string(num / m_Inside);
-    }
-    else
-    {
-        std::stringstream s;
-        this->print(s);
-        std::string thisCell = s.str();
-        if (operation == "+" && !isFirst)
-            ret = operand + thisCell;
-        else if (operation == "+" && isFirst)
-            ret = thisCell + operand;
-        else if (operation == "-" && isFirst)
-            ret = operand;
-        else if (operation == "-" && !isFirst)
-            ret = thisCell;
-        else if (operation == "*")
-        {
-            for (int i = 0; i < (int)m_Inside; i++)
-                ret += operand;
-        }
-        else
-            throw std::logic_error("Cannot execute " + operation + " on a line");
-    }
+/**
+ * @brief Helping function, which appends name of a Cell moved by a given distance
+ *
+ * @param buffer line, where name will be appended
+ * @param name name of a Cell as it is written in a formula
+ * @param rows number of rows, by which Cell is moved
+ * @param columns number of columns, by which Cell is moved
+ */
+static void appendMoved(std::string &buffer, const std::string &name, const int &rows, const int &columns)
+{
+    std::string lower = name;
+    std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+    std::pair<int, int> cord = translateCell(lower);
+    std::string moved = cellName(cord.first + rows, cord.second + columns);
+    if (isupper(name[0]))
+        std::transform(moved.begin(), moved.end(), moved.begin(), ::toupper);
+    buffer += moved;
+}
+
+Instruction Formula::instruction(const size_t &ind, const int &cellRow, const int &cellColumn) const
+{
+    Instruction ret = code.code[ind];
+    if (ret.op != OpCode::CELL && ret.op != OpCode::SUM && ret.op != OpCode::AVG && ret.op != OpCode::MIN && ret.op != OpCode::MAX && ret.op != OpCode::COUNT)
+        return ret;
+    ret.row += cellRow - row;
+    ret.rowEnd += cellRow - row;
+    ret.column += cellColumn - column;
+    ret.columnEnd += cellColumn - column;
     return ret;
 }
 
-std::string NumCell::function(const std::string &operation) const
+void Formula::appendText(std::string &buffer, const int &cellRow, const int &cellColumn) const
 {
-    std::string res;
-    if (operation == "sin")
-        res = std::to_string(::sin(m_Inside));
-    else if (operation == "cos")
-        res = std::to_string(::cos(m_Inside));
-    else if (operation == "sqrt")
+    if (cellRow == row && cellColumn == column)
     {
-        if (m_Inside < 0)
-            throw std::logic_error("Cannot execute sqrt on a negative number");
-        res = std::to_string(::sqrt(m_Inside));
+        buffer += text;
+        return;
     }
-    return res;
-}
-
-StringCell::StringCell() : Cell(), m_Inside("") {}
-
-StringCell::StringCell(const StringCell &src) : Cell(), m_Inside(src.m_Inside) {}
-
-StringCell::~StringCell() {}
-
-size_t StringCell::getLength() const
-{
-    return m_Inside.size();
-}
-
-void StringCell::print(std::ostream &os) const
-{
-    os << m_Inside;
-}
-
-void StringCell::setValue(const std::string &newValue)
-{
-    m_Inside = newValue;
-}
-
-std::string StringCell::getValue()
-{
-    return m_Inside;
-}
-
-std::string StringCell::whatIs() const
-{
-    return "StringCell";
-}
-
-std::string StringCell::operation(const std::string &operation, const std::string &operand, const bool &isFirst) const
-{
-    std::string ret;
-    if (isNum(operand))
+    //Formula is split to words in the same way, as it is converted to RPN, only references are changed
+    size_t start = 0;
+    while (true)
     {
-        double num = std::stod(operand);
-        if (operation == "+" && isFirst)
-            ret = m_Inside + operand;
-        else if (operation == "+" && !isFirst)
-            ret = operand + m_Inside;
-        else if (operation == "-" && isFirst)
-            ret = m_Inside;
-        else if (operation == "-" && !isFirst)
-            ret = operand;
-        else if (operation == "*")
+        size_t end = std::min(text.find(' ', start), text.size());
+        std::string word = text.substr(start, end - start);
+        std::string lower = word;
+        std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+        if (detectIfIsCell(lower))
+            appendMoved(buffer, word, cellRow - row, cellColumn - column);
+        else if (detectIfIsRange(lower))
         {
-            for (int i = 0; i < (int)num; i++)
-                ret += m_Inside;
+            appendMoved(buffer, word.substr(0, word.find(':')), cellRow - row, cellColumn - column);
+            buffer += ':';
+            appendMoved(buffer, word.substr(word.find(':') + 1), cellRow - row, cellColumn - column);
         }
         else
-            throw std::logic_error("Cannot execute" + operation + "on a line");
-    }
-    else
-    {
-        if (operation == "+" && isFirst)
-            ret = m_Inside + operand;
-        else if (operation == "+" && !isFirst)
-            ret = operand + m_Inside;
-        else if (operation == "-" && isFirst)
-            ret = m_Inside;
-        else if (operation == "-" && !isFirst)
-            ret = operand;
-        else
-            throw std::logic_error("Cannot execute" + operation + "on a line");
-    }
-    return ret;
-}
-
-std::string StringCell::function(const std::string &operation) const
-{
-    throw std::logic_error("Cannot execute " + operation + " on a line");
-    return operation;
-}
-
-CellFunc::CellFunc() : Cell(), m_FormulaPrint(""), m_Inside(""), m_Formula(0) {}
-
-CellFunc::~CellFunc() {}
-
-CellFunc::CellFunc(const CellFunc &src) : Cell(), m_FormulaPrint(src.m_FormulaPrint), m_Inside(src.m_Inside), m_Formula(src.m_Formula) {}
-
-void CellFunc::printFunc(std::ostream &os) const
-{
-    os << m_FormulaPrint;
-}
-
-void CellFunc::print(std::ostream &os) const
-{
-    if (isNum(m_Inside))
-    {
-        NumCell cell;
-        cell.setValue(std::stod(m_Inside));
-        cell.print(os);
-        return;
-    }
-    os << m_Inside;
-}
-
-void CellFunc::setFormula(const std::string &line)
-{
-    m_FormulaPrint = line;
-    Operators op;
-    op.convertLine(line);
-    m_Formula = op.returnLine();
-}
-
-std::string CellFunc::whatIs() const
-{
-    return "CellFunc";
-}
-
-size_t CellFunc::getLength() const
-{
-    if (isNum(m_Inside))
-    {
-        NumCell cell;
-        cell.setValue(std::stod(m_Inside));
-        return cell.getLength();
-    }
-    return m_Inside.length();
-}
-
-void CellFunc::setInside(const std::string &src)
-{
-    m_Inside = src;
-}
-
-std::vector<std::string> CellFunc::getFormula() const
-{
-    return m_Formula;
-}
-
-std::string CellFunc::operation(const std::string &operation, const std::string &operand, const bool &isFirst) const
-{
-    std::string res;
-    if (isNum(m_Inside))
-    {
-        NumCell help;
-        help.setValue(std::stod(m_Inside));
-        res = help.operation(operation, operand, isFirst);
-    }
-    else
-    {
-        StringCell help;
-        help.setValue(m_Inside);
-        res = help.operation(operation, operand, isFirst);
-    }
-    return res;
-}
-
-std::string CellFunc::function(const std::string &operation) const
-{
-    std::string res;
-    if (isNum(m_Inside))
-    {
-        NumCell help;
-        help.setValue(std::stod(m_Inside));
-        res = help.function(operation);
-    }
-    else
-    {
-        StringCell help;
-        help.setValue(m_Inside);
-        res = help.function(operation);
+            buffer += word;
+        if (end == text.size())
+            break;
+        buffer += ' ';
+        start = end + 1;
     }
-    return res;
 }
 
-#endif // CELL_CPP
\ No newline at end of file
+#endif // CELL_CPP
@@ -1,9 +1,9 @@
 /**
  * @file cell.h
  * @author Daria Tiurina (tiuridar@fit.cvut.cz)
- * @brief Declaration of classes Cell, NumCell and StringCell
- * @version 0.9
- * @date 2023-05-12
+ * @brief Declaration of class Cell and structure Formula
+ * @version 1.0
+ * @date 2023-06-05
  *
  * @copyright Copyright (c) 2023
  *
@@ -15,297 +15,156 @@
 #include <cstring>
 #include <set>
 #include <iostream>
+#include "../operators/operators.h"
+#include "../value/value.h"
 
 /**
- * @brief Class Cell, which defines one empty cell in a table
+ * @brief Types of a Cell
  *
  */
-class Cell
+enum class CellType : unsigned char
 {
-public:
-    /**
-     * @brief Construct a new Cell object
-     */
-    Cell();
-
-    /**
-     * @brief Destroy the Cell object
-     */
-    virtual ~Cell();
-
-    /**
-     * @brief Virtual function, which writes Cell's data to a ostream
-     * @param os Ostream, where Cell is needed to be printed
-     */
-    virtual void print(std::ostream &os) const;
-
-    /**
-     * @brief Print formula
-     *
-     * @param os Ostream, where formula will be printed
-     */
-    virtual void printFunc(std::ostream &os) const;
-
-    /**
-     * @brief Get the Length object
-     * @return size_t
-     */
-    virtual size_t getLength() const;
-
-    /**
-     * @brief Get the formula from a Cell
-     *
-     * @return std::vector<std::string> formula in RPN
-     */
-    virtual std::vector<std::string> getFormula() const;
-
-    /**
-     * @brief Set the inside in Cell
-     *
-     * @param src line, which needs to be set in a Cell
-     */
-    virtual void setInside(const std::string &src);
-
-    /**
-     * @brief Detects which Cell it is
-     *
-     * @return std::string which Cell is it
-     */
-    virtual std::string whatIs() const;
-
-    /**
-     * @brief Execute function on a Cell
-     *
-     * @param operation which function needs to be executed
-     * @return std::string result of an operation
-     * @exception if operation cannot be executed throws an exception
-     */
-    virtual std::string function(const std::string &operation) const;
-
-    /**
-     * @brief Execute math operation on a Cell
-     *
-     * @param operation operation which function needs to be executed
-     * @param operand second number or line, which will be in function
-     * @param isFirst true if Cell is first in operation
-     * @return std::string std::string result of an operation
-     */
-    virtual std::string operation(const std::string &operation, const std::string &operand, const bool &isFirst) const;
-
-    /**
-     * @brief Output operator to a given ostream
-     * @param os ostream, where insides will be printed
-     * @param src Cell which needs to be printed
-     * @return std::ostream&
-     */
-    friend std::ostream &operator<<(std::ostream &os, const Cell &src);
+    EMPTY,   //!< Cell without data
+    NUMBER,  //!< Cell with a number written inside
+    STRING,  //!< Cell with a word or sentence written inside
+    FORMULA  //!< Cell with a formula inside
 };
 
 /**
- * @brief Child class from class Cell. Defines Cell with a number written inside
+ * @brief Formula, which is referenced by a Cell
+ *
  */
-class NumCell : public Cell
+struct Formula
 {
-public:
-    /**
-     * @brief Construct a new Num Cell object
-     */
-    NumCell();
+    //!> formula in normal rotation, as it is written in a Cell, where formula was created
+    std::string text;
 
-    /**
-     * @brief Construct a new Num Cell object copied from a source NumCell
-     * @param src NumCell, which is needed to be copied
-     */
-    NumCell(const NumCell &src);
+    //!> formula compiled after convertion to RPN with references of a Cell, where formula was created
+    Bytecode code;
 
-    NumCell(const int &src);
-
-    /**
-     * @brief Destroy the Num Cell object
-     */
-    ~NumCell();
+    //!> row of a Cell, where formula was created
+    int row = 0;
 
-    /**
-     * @brief Get the length of a number inside a NumCell
-     * @return size_t number of symbols inside NumCell's data
-     */
-    size_t getLength() const override;
+    //!> column of a Cell, where formula was created
+    int column = 0;
 
-    /**
-     * @brief Prints NumCell's data to a given ostream
-     * @param os ostream, where data need to be printed
-     */
-    void print(std::ostream &os) const override;
+    //!> number of Cells, which share formula
+    size_t users = 0;
 
     /**
-     * @brief Returns that this is NumCell
+     * @brief Get the instruction for a Cell, which shares formula. References are moved by a distance between Cells
      *
-     * @return std::string NumCell
+     * @param ind index of an instruction
+     * @param cellRow row, where Cell is situated
+     * @param cellColumn column, where Cell is situated
+     * @return Instruction instruction with references of a Cell
      */
-    std::string whatIs() const override;
+    Instruction instruction(const size_t &ind, const int &cellRow, const int &cellColumn) const;
 
     /**
-     * @brief Execute math operation on a Cell
+     * @brief Appends formula in normal rotation, as it is written in a Cell, which shares formula
      *
-     * @param operation operation which function needs to be executed
-     * @param operand second number or line, which will be in function
-     * @param isFirst true if Cell is first in operation
-     * @return std::string std::string result of an operation
+     * @param buffer line, where formula will be appended
+     * @param cellRow row, where Cell is situated
+     * @param cellColumn column, where Cell is situated
      */
-    std::string operation(const std::string &operation, const std::string &operand, const bool &isFirst) const override;
-
-    /**
-     * @brief Return the number from a NumCell
-     * @return double data inside NumCell
-     */
-    double getValue();
-
-    /**
-     * @brief Execute function on a Cell
-     *
-     * @param operation which function needs to be executed
-     * @return std::string result of an operation
-     * @exception if operation cannot be executed throws an exception
-     */
-    std::string function(const std::string &operation) const override;
-
-    /**
-     * @brief Set value to a NumCell
-     * @param newValue number, which is needed to be inside a NumCell
-     */
-    void setValue(const double &newValue);
-
-private:
-    double m_Inside; //!< data's inside a NumCell
+    void appendText(std::string &buffer, const int &cellRow, const int &cellColumn) const;
 };
 
 /**
- * @brief Child class from class Cell. Defines Cell with a word or sentence written inside
+ * @brief Class Cell, which defines one cell in a table. Data is stored inside a Cell, formula is referenced by its index
+ *
  */
-class StringCell : public Cell
+class Cell
 {
 public:
     /**
-     * @brief Construct a new String Cell object
-     */
-    StringCell();
-
-    /**
-     * @brief Construct a new String Cell object copied from a source StringCell
-     * @param src source StringCell
+     * @brief Construct a new empty Cell object
      */
-    StringCell(const StringCell &src);
+    Cell();
 
     /**
-     * @brief Destroy the String Cell object
+     * @brief Destroy the Cell object
      */
-    ~StringCell();
+    ~Cell();
 
     /**
-     * @brief Get length of a StringCell's data
-     * @return size_t number of symbols in StringCell's data
+     * @brief Detects which Cell it is
+     *
+     * @return CellType type of a Cell
      */
-    size_t getLength() const override;
+    CellType getType() const;
 
     /**
-     * @brief Get the value inside a StringCell
-     * @return std::string data's inside a StringCell
+     * @brief Checks if Cell is empty
+     *
+     * @return true Cell doesn't have any data
+     * @return false Cell has data or formula
      */
-    std::string getValue();
+    bool isEmpty() const;
 
     /**
-     * @brief Prints StringCell's data to a given ostream
-     * @param os ostream, where data need to be printed
+     * @brief Writes Cell's data or result of a formula to a ostream
+     * @param os Ostream, where Cell is needed to be printed
      */
-    void print(std::ostream &os) const override;
+    void print(std::ostream &os) const;
 
     /**
-     * @brief Set value to a StringCell
-     * @param newValue word or sentence, which is needed to be inside a StringCell
+     * @brief Get the length of a printed Cell
+     * @return size_t number of symbols inside Cell's data
      */
-    void setValue(const std::string &newValue);
+    size_t getLength() const;
 
     /**
-     * @brief Execute math operation on a Cell
+     * @brief Get the Value inside a Cell
      *
-     * @param operation operation which function needs to be executed
-     * @param operand second number or line, which will be in function
-     * @param isFirst true if Cell is first in operation
-     * @return std::string std::string result of an operation
+     * @return const Value& data or result of a formula
      */
-    std::string operation(const std::string &operation, const std::string &operand, const bool &isFirst) const override;
+    const Value &getValue() const;
 
     /**
-     * @brief Execute function on a Cell
-     *
-     * @param operation which function needs to be executed
-     * @return std::string result of an operation
-     * @exception if operation cannot be executed throws an exception
+     * @brief Set number to a Cell
+     * @param newValue number, which is needed to be inside a Cell
      */
-    std::string function(const std::string &operation) const override;
+    void setNumber(const double &newValue);
 
     /**
-     * @brief Returns that this is StringCell
-     *
-     * @return std::string StringCell
+     * @brief Set line to a Cell
+     * @param newValue word or sentence, which is needed to be inside a Cell
      */
-    std::string whatIs() const override;
-
-private:
-    std::string m_Inside; //!< data's inside a StringCell
-};
-
-/**
- * @brief Child class from class Cell. Defines Cell with a formula inside
- * 
- */
-class CellFunc : public Cell
-{
-public:
-    /**
-     * @brief Construct a new Cell Func object
-     *
-     */
-    CellFunc();
+    void setString(const std::string &newValue);
 
     /**
-     * @brief Construct a new Cell Func object from an existing CellFunc
-     *
-     * @param src source CellFunc
+     * @brief Makes Cell a formula
+     * @param index index of a Formula in a table
      */
-    CellFunc(const CellFunc &src);
+    void setFormula(const int &index);
 
     /**
-     * @brief Destroy the Cell Func object
-     *
+     * @brief Get index of a Formula
+     * @return int index of a Formula in a table, -1 if Cell is not a formula
      */
-    ~CellFunc();
+    int getFormula() const;
 
     /**
-     * @brief Set the formula inside CellFunc
+     * @brief Set the counted result of a formula
      *
-     * @param line formula, which will be than translated
+     * @param src Value, which needs to be set in a Cell
      */
-    void setFormula(const std::string &line);
+    void setInside(const Value &src);
 
     /**
-     * @brief Prints CellFunc's data to a given ostream
-     * @param os ostream, where data need to be printed
+     * @brief Makes Cell empty
      */
-    void print(std::ostream &os) const override;
+    void clear();
 
     /**
-     * @brief Get the formula from a Cell
+     * @brief Execute function on a Cell
      *
-     * @return std::vector<std::string> formula in RPN
-     */
-    std::vector<std::string> getFormula() const;
-
-    /**
-     * @brief Get the length of a number inside a NumCell
-     * @return size_t number of symbols inside NumCell's data
+     * @param operation which function needs to be executed
+     * @return Value result of an operation or error Value, if operation cannot be executed
      */
-    size_t getLength() const;
+    Value function(const OpCode &operation) const;
 
     /**
      * @brief Execute math operation on a Cell
@@ -313,46 +172,27 @@ public:
      * @param operation operation which function needs to be executed
      * @param operand second number or line, which will be in function
      * @param isFirst true if Cell is first in operation
-     * @return std::string std::string result of an operation
+     * @return Value result of an operation or error Value, if operation cannot be executed
      */
-    std::string operation(const std::string &operation, const std::string &operand, const bool &isFirst) const override;
+    Value operation(const OpCode &operation, const Value &operand, const bool &isFirst) const;
 
     /**
-     * @brief Execute function of a Cell
-     *
-     * @param operation which function needs to be executed
-     * @return std::string result of an operation
-     * @exception if operation cannot be executed throws an exception
-     */
-    std::string function(const std::string &operation) const override;
-
-    /**
-     * @brief Returns that this is CellFunc
-     *
-     * @return std::string CellFunc
+     * @brief Output operator to a given ostream
+     * @param os ostream, where insides will be printed
+     * @param src Cell which needs to be printed
+     * @return std::ostream&
      */
-    std::string whatIs() const override;
+    friend std::ostream &operator<<(std::ostream &os, const Cell &src);
 
-    /**
-     * @brief Set the inside in Cell
-     *
-     * @param src line, which needs to be set in a Cell
-     */
-    void setInside(const std::string &src);
+private:
+    //!> type of a Cell
+    CellType m_Type;
 
-    /**
-     * @brief Prints formula to a given ostream
-     * @param os ostream, where data need to be printed
-     */
-    void printFunc(std::ostream &os) const;
+    //!> index of a Formula in a table
+    int m_Formula;
 
-private:
-    //!> formula in normal rotation
-    std::string m_FormulaPrint;
-    //!> result of formula
-    std::string m_Inside;
-    //!> formula in RPN after convertion
-    std::vector<std::string> m_Formula;
+    //!> data or result of a formula
+    Value m_Inside;
 };
 
 #endif // CELL_H
@@ -30,6 +30,8 @@ std::string Commands::convertCommand(const std::string &line, const size_t &posi
     {
         if (tmp == "exit" || tmp == "print" || tmp == "export" || tmp == "import" || tmp == "formula")
             return tmp;
+        else if (tmp == "begin" || tmp == "commit" || tmp == "rollback")
+            return tmp;
         else if (detectIfIsCell(tmp))
         {
             m_HelpString.push_back(tmp);
@@ -43,6 +45,8 @@ std::string Commands::convertCommand(const std::string &line, const size_t &posi
     {
         if (tmp == "all" || tmp == "formula" || tmp == "=")
             return tmp;
+        else if (tmp == "page" && m_Commands[0] == "print")
+            return tmp;
         else if (detectIfIsCell(tmp))
         {
             this->m_HelpString.push_back(tmp);
@@ -113,9 +117,30 @@ void Commands::checkSequence()
         if (m_Commands[i] == "print" || m_Commands[i] == "=" || m_Commands[i] == "exit" || m_Commands[i] == "import" || m_Commands[i] == "export" || m_Commands[i] == "del")
             hasCommand = true;
 
+    //Commands of a transaction don't have any other words
+    if (!m_Commands.empty() && (m_Commands[0] == "begin" || m_Commands[0] == "commit" || m_Commands[0] == "rollback"))
+    {
+        if (m_Commands.size() != 1)
+            throw std::logic_error("Unknown command");
+        return;
+    }
+
     if (!hasCommand)
         throw std::logic_error("Unknown command");
 
+    //Last word of export or import can be a format of a file
+    if (m_Commands.size() >= 3 && (m_Commands[0] == "export" || m_Commands[0] == "import") && m_Commands.back() == "src")
+    {
+        std::string format = m_HelpString.back();
+        std::transform(format.begin(), format.end(), format.begin(), ::tolower);
+        if (format == "binary")
+        {
+            m_Commands.back() = "binary";
+            m_HelpString.pop_back();
+            return;
+        }
+    }
+
     if (m_Commands.size() == 1)
     {
         //adds helping words for processing
@@ -139,6 +164,11 @@ void Commands::checkSequence()
         {
             m_Commands.push_back("all");
         }
+        else if (m_Commands[0] == "print" && m_Commands[1] == "page")
+        {
+            m_Commands.push_back("src");
+            m_HelpString.push_back("1");
+        }
         else if ((m_Commands[0] == "print" || m_Commands[0] == "del") && (m_Commands[1] != "cellnum" && m_Commands[1] != "cellrange" && m_Commands[1] != "all"))
         {
             throw std::logic_error("Unknown command");
@@ -156,7 +186,7 @@ void Commands::checkSequence()
     }
     else if (m_Commands.size() == 3)
     {
-        if (m_Commands[0] == "print" && m_Commands[1] != "formula")
+        if (m_Commands[0] == "print" && m_Commands[1] != "formula" && (m_Commands[1] != "page" || m_Commands[2] != "src"))
             throw std::logic_error("Unknown command");
         else if (m_Commands[1] == "=" && (m_Commands[0] != "cellnum" || (m_Commands[2] != "src" && m_Commands[2] != "cellnum")))
             throw std::logic_error("Unknown command");
@@ -164,6 +194,12 @@ void Commands::checkSequence()
             if (m_Commands[i] == "export" || m_Commands[i] == "import" || m_Commands[i] == "exit")
                 throw std::logic_error("Unknown command");
     }
+    else if (m_Commands[0] == "print")
+    {
+        //Only page can have a page of rows and a page of columns
+        if (m_Commands.size() != 4 || m_Commands[1] != "page" || m_Commands[2] != "src" || m_Commands[3] != "src")
+            throw std::logic_error("Unknown command");
+    }
     else
     {
         if (m_Commands[1] != "=" && m_Commands[0] != "formula" && m_Commands[0] != "export" && m_Commands[0] != "import")
@@ -171,6 +207,11 @@ void Commands::checkSequence()
     }
 }
 
+void Commands::setInput(const std::string &input)
+{
+    m_Input = input;
+}
+
 std::vector<std::string> Commands::getCommands() const
 {
     return this->m_Commands;
@@ -185,7 +226,7 @@ std::istream &operator>>(std::istream &is, Commands &dest)
 {
     try
     {
-        std::getline(std::cin, dest.m_Input);
+        std::getline(is, dest.m_Input);
     }
     catch (const std::exception &ex)
     {
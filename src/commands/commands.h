@@ -45,6 +45,12 @@ public:
      */
     friend std::istream &operator>>(std::istream &is, Commands &dest);
 
+    /**
+     * @brief Set the line, which will be checked, instead of reading it from an input
+     * @param input one line with a command
+     */
+    void setInput(const std::string &input);
+
     /**
      * @brief Function checks what was written by a user
      */
@@ -17,8 +17,9 @@
 #include <unistd.h>
 #include <fstream>
 #include <cmath>
+#include <sstream>
 
-Execute::Execute(const Commands &command, Tables *src) : m_Command(command), m_Table(src) {}
+Execute::Execute(const Commands &command, Tables *src, const bool &interactive) : m_Command(command), m_Table(src), m_Interactive(interactive) {}
 
 Execute::~Execute() {}
 
@@ -70,6 +71,18 @@ bool Execute::executeCommand()
             std::pair<int, int> cell2 = translateCell(line2);
             m_Table->printRange(cell1.first, cell1.second, cell2.first, cell2.second);
         }
+        else if (doCommand[1] == "page")
+        {
+            std::stringstream pages(help[0]);
+            long rowPage = 0;
+            long columnPage = 1;
+            pages >> rowPage;
+            if (!pages.eof())
+                pages >> columnPage;
+            if (pages.fail() || !pages.eof() || rowPage <= 0 || columnPage <= 0)
+                throw std::logic_error("Wrong number of a page");
+            m_Table->printPage((size_t)rowPage, (size_t)columnPage);
+        }
         if (doCommand[1] == "formula")
         {
             if (doCommand[2] == "all")
@@ -115,11 +128,15 @@ bool Execute::executeCommand()
     }
     else if (doCommand[0] == "export")
     {
-        std::ofstream fileOut("examples/" + help[0], std::ios::trunc);
-        if (fileOut.is_open())
-            m_Table->exportTable(fileOut);
-        else
+        m_Table->updateInsideFormula();
+        bool binary = doCommand.back() == "binary";
+        std::ofstream fileOut("examples/" + help[0], binary ? std::ios::trunc | std::ios::binary : std::ios::trunc);
+        if (!fileOut.is_open())
             throw std::logic_error("File cannot be made");
+        if (binary)
+            m_Table->exportBinary(fileOut);
+        else
+            m_Table->exportTable(fileOut);
 
         fileOut.close();
     }
@@ -129,7 +146,8 @@ bool Execute::executeCommand()
         std::ifstream fileIn("examples/" + help[0]);
         if (!fileIn.is_open())
             throw std::logic_error("File cannot be open");
-        if (!m_Table->isEmpty())
+        //Script cannot answer a question, table is rewritten
+        if (!m_Table->isEmpty() && m_Interactive)
         {
             std::cout << "|-> Table is not empty. Continue? y/n" << std::endl;
             ok = false;
@@ -149,10 +167,18 @@ bool Execute::executeCommand()
         }
         if (!ok)
             return true;
-        m_Table->deleteAll();
-        m_Table->importTable(fileIn);
         fileIn.close();
+        if (doCommand.back() == "binary")
+            m_Table->importBinary("examples/" + help[0]);
+        else
+            m_Table->importTable("examples/" + help[0]);
     }
+    else if (doCommand[0] == "begin")
+        m_Table->begin();
+    else if (doCommand[0] == "commit")
+        m_Table->commit();
+    else if (doCommand[0] == "rollback")
+        m_Table->rollback();
     else if (doCommand[0] == "formula")
     {
         std::pair<int, int> cell = translateCell(help[0]);
@@ -168,11 +194,62 @@ bool Execute::executeCommand()
             std::pair<int, int> cell2 = translateCell(help[1]);
             m_Table->copyValue(cell.first, cell.second, cell2.first, cell2.second);
         }
-        m_Table->updateInsideFormula();
+        if (!m_Table->isDeferred())
+            m_Table->updateInsideFormula();
     }
     else
         throw std::logic_error("Unknown command");
     return true;
 }
 
+bool Execute::runScript(std::istream &input, Tables &table)
+{
+    table.setDeferred(true);
+    bool ok = true;
+    Commands c;
+    std::string line;
+    size_t number = 0;
+    while (std::getline(input, line))
+    {
+        number++;
+        if (line.find_first_not_of(' ') == std::string::npos)
+            continue;
+        try
+        {
+            c.setInput(line);
+            c.checkCommand();
+            c.checkSequence();
+            Execute newCommand(c, &table, false);
+            if (!newCommand.executeCommand())
+                break;
+        }
+        catch (const std::exception &ex)
+        {
+            std::cout << "|-> ERROR DETECTED ON LINE " << number << ": " << ex.what() << std::endl;
+            table.deleteEmpty();
+            ok = false;
+        }
+    }
+
+    if (table.inTransaction())
+    {
+        std::cout << "|-> ERROR DETECTED AT THE END OF A SCRIPT: Transaction is not committed. Transaction is rolled back" << std::endl;
+        table.rollback();
+        ok = false;
+    }
+
+    //Formulas, which cannot be counted, get an error, so they are counted once
+    try
+    {
+        table.updateInsideFormula();
+    }
+    catch (const std::exception &ex)
+    {
+        std::cout << "|-> ERROR DETECTED AT THE END OF A SCRIPT: " << ex.what() << std::endl;
+        table.deleteEmpty();
+        ok = false;
+    }
+    return ok;
+}
+
 #endif // EXECUTE_CPP
\ No newline at end of file
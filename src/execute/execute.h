@@ -25,8 +25,9 @@ public:
      * @brief Construct a new Execute object
      * @param command Commands which is needed to be executed
      * @param src On what Tables will be Commands executed
+     * @param interactive false if a user cannot answer questions, e.g. in a script
      */
-    Execute(const Commands &command, Tables *src);
+    Execute(const Commands &command, Tables *src, const bool &interactive = true);
 
     /**
      * @brief Destroy the Execute object
@@ -40,12 +41,24 @@ public:
      */
     bool executeCommand();
 
+    /**
+     * @brief Executes commands from a script one after another without questions to a user. Formulas are counted only before print, export and at the end of a script
+     * @param input script with one command on a line
+     * @param table Tables, on which commands will be executed
+     * @return true every command was executed
+     * @return false at least one error was reported
+     */
+    static bool runScript(std::istream &input, Tables &table);
+
 private:
     //!> Commands, which will be executed
     const Commands m_Command;
 
     //!> Tables, on which Commands will be executed
     Tables *m_Table;
+
+    //!> false if Commands cannot ask a user
+    const bool m_Interactive;
 };
 
 #endif // EXECUTE_H
@@ -9,94 +9,147 @@
  * 
  */
 #include "graph.h"
+#include <algorithm>
 
-Graph::Graph(int sizeS)
-{
-    this->size = sizeS;
-    adj = new std::list<int>[size];
-}
+Graph::Graph(int sizeS) : size(sizeS), edges(), offsets(sizeS + 1, 0), targets() {}
 
-Graph::~Graph(){
-    delete[] adj;
-}
+Graph::~Graph() {}
 
 void Graph::addEdge(int ind, int anotherInd)
 {
-    adj[ind].push_back(anotherInd);
+    edges.push_back(std::pair<int, int>(ind, anotherInd));
 }
 
-void Graph::topologicalSortUtil(int v, bool visited[], std::stack<int> &Stack)
+void Graph::build()
 {
-    visited[v] = true;
-
-    std::list<int>::iterator i;
-    for (i = adj[v].begin(); i != adj[v].end(); ++i)
-        if (!visited[*i])
-            topologicalSortUtil(*i, visited, Stack);
+    if (edges.empty())
+        return;
+    //Edges added after previous build are merged with already built ones
+    std::vector<std::pair<int, int>> added;
+    added.swap(edges);
+    for (int i = 0; i < size; i++)
+        for (int j = offsets[i]; j < offsets[i + 1]; j++)
+            edges.push_back(std::pair<int, int>(i, targets[j]));
+    edges.insert(edges.end(), added.begin(), added.end());
+    std::fill(offsets.begin(), offsets.end(), 0);
 
-    Stack.push(v);
+    //Counting sort by start of an edge
+    for (std::size_t i = 0; i < edges.size(); i++)
+        offsets[edges[i].first + 1]++;
+    for (int i = 0; i < size; i++)
+        offsets[i + 1] += offsets[i];
+    std::vector<int> position(offsets.begin(), offsets.end() - 1);
+    targets.resize(offsets[size]);
+    for (std::size_t i = 0; i < edges.size(); i++)
+        targets[position[edges[i].first]++] = edges[i].second;
+    edges.clear();
+    edges.shrink_to_fit();
 }
 
-std::vector<int> Graph::topologicalSort()
+std::vector<std::vector<int>> Graph::levels()
 {
-    std::stack<int> Stack;
-
-    bool *visited = new bool[size];
+    this->build();
+    //Number of edges to points, which are not in any level yet
+    std::vector<int> waiting(size, 0);
+    //Reversed edges in CSR
+    std::vector<int> reverseOffsets(size + 1, 0);
+    for (std::size_t i = 0; i < targets.size(); i++)
+        reverseOffsets[targets[i] + 1]++;
+    for (int i = 0; i < size; i++)
+        reverseOffsets[i + 1] += reverseOffsets[i];
+    std::vector<int> position(reverseOffsets.begin(), reverseOffsets.end() - 1);
+    std::vector<int> reverse(targets.size());
     for (int i = 0; i < size; i++)
-        visited[i] = false;
+    {
+        waiting[i] = offsets[i + 1] - offsets[i];
+        for (int j = offsets[i]; j < offsets[i + 1]; j++)
+            reverse[position[targets[j]]++] = i;
+    }
 
+    std::vector<int> current;
     for (int i = 0; i < size; i++)
-        if (visited[i] == false)
-            topologicalSortUtil(i, visited, Stack);
+        if (waiting[i] == 0)
+            current.push_back(i);
 
-    std::vector<int> ret;
-    while (Stack.empty() == false)
+    std::vector<std::vector<int>> ret;
+    while (!current.empty())
     {
-        ret.push_back(Stack.top());
-        Stack.pop();
+        std::vector<int> next;
+        for (std::size_t i = 0; i < current.size(); i++)
+            for (int j = reverseOffsets[current[i]]; j < reverseOffsets[current[i] + 1]; j++)
+                if (--waiting[reverse[j]] == 0)
+                    next.push_back(reverse[j]);
+        ret.push_back(current);
+        current.swap(next);
     }
-
-    delete[] visited;
     return ret;
 }
 
-bool Graph::isCyclicUtil(int v, bool visited[], bool* recStack)
+std::vector<int> Graph::topologicalSort()
 {
-    if (visited[v] == false) {
-        visited[v] = true;
-        recStack[v] = true;
- 
-        std::list<int>::iterator i;
-        for (i = adj[v].begin(); i != adj[v].end(); ++i) {
-            if (!visited[*i]
-                && isCyclicUtil(*i, visited, recStack))
-                return true;
-            else if (recStack[*i])
-                return true;
+    this->build();
+    std::vector<int> order;
+    std::vector<bool> visited(size, false);
+    //Explicit stack of points and index of next edge, which will be visited
+    std::vector<std::pair<int, int>> stack;
+    for (int i = 0; i < size; i++)
+    {
+        if (visited[i])
+            continue;
+        visited[i] = true;
+        stack.push_back(std::pair<int, int>(i, offsets[i]));
+        while (!stack.empty())
+        {
+            std::pair<int, int> &top = stack.back();
+            if (top.second == offsets[top.first + 1])
+            {
+                order.push_back(top.first);
+                stack.pop_back();
+                continue;
+            }
+            int next = targets[top.second++];
+            if (!visited[next])
+            {
+                visited[next] = true;
+                stack.push_back(std::pair<int, int>(next, offsets[next]));
+            }
         }
     }
 
-    recStack[v] = false;
-    return false;
+    //Points were finished from the last one
+    return std::vector<int>(order.rbegin(), order.rend());
 }
 
 bool Graph::isCyclic()
 {
-    bool* visited = new bool[size];
-    bool* recStack = new bool[size];
-    for (int i = 0; i < size; i++) {
-        visited[i] = false;
-        recStack[i] = false;
-    }
-
+    this->build();
+    //0 - not visited, 1 - on the current path, 2 - finished
+    std::vector<unsigned char> state(size, 0);
+    std::vector<std::pair<int, int>> stack;
     for (int i = 0; i < size; i++)
-        if (!visited[i] && isCyclicUtil(i, visited, recStack)){
-            delete[] visited;
-            delete[] recStack;
-            return true;
+    {
+        if (state[i] != 0)
+            continue;
+        state[i] = 1;
+        stack.push_back(std::pair<int, int>(i, offsets[i]));
+        while (!stack.empty())
+        {
+            std::pair<int, int> &top = stack.back();
+            if (top.second == offsets[top.first + 1])
+            {
+                state[top.first] = 2;
+                stack.pop_back();
+                continue;
+            }
+            int next = targets[top.second++];
+            if (state[next] == 1)
+                return true;
+            if (state[next] == 0)
+            {
+                state[next] = 1;
+                stack.push_back(std::pair<int, int>(next, offsets[next]));
+            }
         }
- 
-    delete[] visited;
-    delete[] recStack;
+    }
     return false;
-}
\ No newline at end of file
+}
@@ -11,8 +11,7 @@
 #ifndef GRAPH_H
 #define GRAPH_H
 #include <vector>
-#include <list>
-#include <stack>
+#include <utility>
 
 /**
  * @brief ADT Graph
@@ -49,6 +48,14 @@ public:
      */
     std::vector<int> topologicalSort();
 
+    /**
+     * @brief Splits points to levels (Kahn's algorithm). Point is in a level after all points it has edges to,
+     * so points of one level don't depend on each other. Points on a cycle are not in any level
+     *
+     * @return std::vector<std::vector<int>> indexes of elements by levels, starting with points without edges
+     */
+    std::vector<std::vector<int>> levels();
+
     /**
      * @brief Detects if graph has cycle
      *
@@ -61,14 +68,17 @@ private:
     //!> number of points in graph
     int size;
 
-    //!> connections between points
-    std::list<int> *adj;
+    //!> added edges, they are moved to CSR arrays before first traversal
+    std::vector<std::pair<int, int>> edges;
+
+    //!> CSR: edges from point i are targets[offsets[i]] .. targets[offsets[i + 1] - 1]
+    std::vector<int> offsets;
 
-    //!> helping recursion function for Topological sort
-    void topologicalSortUtil(int v, bool visited[], std::stack<int> &Stack);
+    //!> CSR: ends of edges grouped by their start
+    std::vector<int> targets;
 
-    //!> helping recursion function for cycle detection
-    bool isCyclicUtil(int v, bool visited[], bool *rs);
+    //!> builds CSR arrays from added edges, keeps order in which edges were added
+    void build();
 };
 
 #endif // GRAPH_H
\ No newline at end of file
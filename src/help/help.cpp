@@ -14,6 +14,13 @@
 #include <sstream>
 #include <deque>
 #include <cmath>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <vector>
+#include <exception>
+#include <algorithm>
 #include "help.h"
 
 bool detectIfIsRange(const std::string &line)
@@ -166,11 +173,210 @@ void translateRow(std::ostream &os, const size_t &row, const size_t &column)
     os << output << row;
 }
 
+std::string cellName(const int &row, const int &column)
+{
+    std::string ret;
+    for (int num = column + 1; num > 0; num = (num - 1) / 26)
+        ret.insert(ret.begin(), (char)('a' + (num - 1) % 26));
+    return ret + std::to_string(row + 1);
+}
+
 bool isFunc(const std::string &line)
 {
-    if (line == "cos" || line == "sin" || line == "sqrt")
+    if (line == "cos" || line == "sin" || line == "sqrt" || isAggregate(line))
+        return true;
+    return false;
+}
+
+bool isAggregate(const std::string &line)
+{
+    if (line == "sum" || line == "avg" || line == "min" || line == "max" || line == "count")
         return true;
     return false;
 }
 
+//!> number of threads, which are used by parallelFor, 0 means number of cores
+static size_t threadCount = 0;
+
+void setThreadCount(const size_t &count)
+{
+    if (count > MAX_THREADS)
+        throw std::logic_error("Wrong number of threads");
+    threadCount = count;
+}
+
+size_t getThreadCount()
+{
+    if (threadCount != 0)
+        return threadCount;
+    return std::max<size_t>(1, std::thread::hardware_concurrency());
+}
+
+//!> true in threads of a pool and in a thread, which waits for a pool, so nested parallelFor runs without a pool
+static thread_local bool insidePool = false;
+
+/**
+ * @brief Class WorkerPool, threads of parallelFor. Threads are started once and wait for next work, so parallelFor doesn't start new threads on every call
+ *
+ */
+class WorkerPool
+{
+public:
+    /**
+     * @brief Destroy the WorkerPool object, stops all threads
+     */
+    ~WorkerPool()
+    {
+        this->resize(0);
+    }
+
+    /**
+     * @brief Runs work on threads of a pool and on a calling thread and waits until all of them are finished
+     *
+     * @param limit max number of threads in a pool, pool with more threads is started again
+     * @param workers number of threads from a pool, which take part in work. Pool with less threads is started again
+     * @param work function, which gets index of a thread, 0 is a calling thread. Must not throw
+     */
+    void run(const size_t &limit, const size_t &workers, const std::function<void(size_t)> &work)
+    {
+        //Pool has only as many threads, as the biggest work needed
+        if (m_Threads.size() < workers || m_Threads.size() > limit)
+            this->resize(std::min(workers, limit));
+        std::unique_lock<std::mutex> lock(m_Mutex);
+        m_Work = &work;
+        m_Workers = std::min(workers, m_Threads.size());
+        m_Pending = m_Workers;
+        m_Generation++;
+        lock.unlock();
+        m_Start.notify_all();
+        work(0);
+        lock.lock();
+        m_Done.wait(lock, [this] { return m_Pending == 0; });
+        m_Work = nullptr;
+    }
+
+private:
+    //!> started threads
+    std::vector<std::thread> m_Threads;
+
+    //!> protects all other members
+    std::mutex m_Mutex;
+
+    //!> wakes threads, when new work is started or pool is stopped
+    std::condition_variable m_Start;
+
+    //!> wakes a calling thread, when all threads finished work
+    std::condition_variable m_Done;
+
+    //!> current work, nullptr if there is none
+    const std::function<void(size_t)> *m_Work = nullptr;
+
+    //!> number of threads, which take part in current work
+    size_t m_Workers = 0;
+
+    //!> number of threads, which haven't finished current work yet
+    size_t m_Pending = 0;
+
+    //!> number of started works, thread takes part in every work only once
+    size_t m_Generation = 0;
+
+    //!> true if threads need to end
+    bool m_Stop = false;
+
+    /**
+     * @brief Stops all threads and starts new ones
+     * @param size number of new threads
+     */
+    void resize(const size_t &size)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_Stop = true;
+        }
+        m_Start.notify_all();
+        for (size_t i = 0; i < m_Threads.size(); i++)
+            m_Threads[i].join();
+        m_Threads.clear();
+        m_Stop = false;
+        for (size_t i = 1; i <= size; i++)
+            m_Threads.emplace_back(&WorkerPool::loop, this, i, m_Generation);
+    }
+
+    /**
+     * @brief Loop of one thread, which waits for work and takes part in it
+     *
+     * @param index index of a thread, calling thread has 0
+     * @param generation number of works, which were started before a thread
+     */
+    void loop(size_t index, size_t generation)
+    {
+        insidePool = true;
+        std::unique_lock<std::mutex> lock(m_Mutex);
+        while (true)
+        {
+            m_Start.wait(lock, [this, generation] { return m_Stop || m_Generation != generation; });
+            if (m_Stop)
+                return;
+            generation = m_Generation;
+            if (index > m_Workers)
+                continue;
+            const std::function<void(size_t)> *work = m_Work;
+            lock.unlock();
+            (*work)(index);
+            lock.lock();
+            if (--m_Pending == 0)
+                m_Done.notify_one();
+        }
+    }
+};
+
+//!> pool used by parallelFor, only one parallelFor can use it at the same time
+static std::mutex poolLock;
+
+void parallelFor(const size_t &count, const size_t &grain, const std::function<void(size_t, size_t)> &work)
+{
+    size_t step = std::max<size_t>(grain, 1);
+    size_t threads = std::min(getThreadCount(), (count + step - 1) / step);
+    //One grain of items is processed by a calling thread, same as items of a parallelFor started while pool is busy
+    std::unique_lock<std::mutex> lock(poolLock, std::defer_lock);
+    if (threads <= 1 || insidePool || !lock.try_lock())
+    {
+        if (count > 0)
+            work(0, count);
+        return;
+    }
+
+    std::atomic<size_t> next(0);
+    std::vector<std::exception_ptr> errors(threads);
+    std::function<void(size_t)> worker = [&](size_t i) {
+        try
+        {
+            for (size_t begin = next.fetch_add(step); begin < count; begin = next.fetch_add(step))
+                work(begin, std::min(count, begin + step));
+        }
+        catch (...)
+        {
+            errors[i] = std::current_exception();
+            next = count;
+        }
+    };
+
+    //Pool is created on first use, so a program without parallel work doesn't start threads
+    static WorkerPool pool;
+    insidePool = true;
+    try
+    {
+        pool.run(getThreadCount() - 1, threads - 1, worker);
+    }
+    catch (...)
+    {
+        insidePool = false;
+        throw;
+    }
+    insidePool = false;
+    for (size_t i = 0; i < errors.size(); i++)
+        if (errors[i])
+            std::rethrow_exception(errors[i]);
+}
+
 #endif // HELP_CPP
\ No newline at end of file
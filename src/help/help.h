@@ -11,6 +11,8 @@
 #ifndef HELP_H
 #define HELP_H
 #include <string>
+#include <functional>
+#include <cstddef>
 
 /**
  * @brief Helping function which detects if given line is CellRange
@@ -47,6 +49,15 @@ std::pair<int, int> translateCell(const std::string &line);
  */
 bool isFunc(const std::string & line);
 
+/**
+ * @brief Helping function, which detects if line is an aggregate function, which takes a range
+ *
+ * @param line string, which may be aggregate function
+ * @return true line is aggregate function
+ * @return false line is not aggregate function
+ */
+bool isAggregate(const std::string &line);
+
 /**
  * @brief Helping function, which detetcts if line is math operation 
  * 
@@ -83,4 +94,43 @@ bool isNum(const std::string &src);
  */
 void translateRow(std::ostream & os, const size_t & row, const size_t & column);
 
+/**
+ * @brief Helping function, which writes cell's name in the same way, as it is written in a formula. Reverse of translateCell
+ *
+ * @param row cell's row index
+ * @param column cell's column index
+ * @return std::string name of a cell in lowercase
+ */
+std::string cellName(const int &row, const int &column);
+
+//!> max number of threads, which can be used by parallelFor
+constexpr size_t MAX_THREADS = 256;
+
+/**
+ * @brief Set number of threads, which are used by parallelFor
+ *
+ * @param count number of threads, 0 means number of cores
+ * @exception if count is bigger than MAX_THREADS throws an exception
+ */
+void setThreadCount(const size_t &count);
+
+/**
+ * @brief Get number of threads, which are used by parallelFor
+ *
+ * @return size_t number of threads, at least 1
+ */
+size_t getThreadCount();
+
+/**
+ * @brief Helping function, which splits items between threads and waits until all of them are processed.
+ * Threads take next grain of items, when they finish previous one. Calling thread works as well.
+ * Threads are started on first call and reused. Pool gets only as many threads, as the biggest call needed, and is started again if it needs more of them or if setThreadCount lowers their number.
+ * Exception thrown by a thread is rethrown after all threads are finished
+ *
+ * @param count number of items
+ * @param grain minimal number of items for one thread
+ * @param work function, which processes items from begin to end (not included)
+ */
+void parallelFor(const size_t &count, const size_t &grain, const std::function<void(size_t, size_t)> &work);
+
 #endif // HELP_H
\ No newline at end of file
@@ -1,7 +1,7 @@
 /**
  * @file line.cpp
  * @author Daria Tiurina (tiuridar@fit.cvut.cz)
- * @brief Implementation of Line class
+ * @brief Implementation of Line class and ColumnWidth class
  * @version 0.9
  * @date 2023-05-12
  *
@@ -19,171 +19,169 @@
 #include <sys/ioctl.h>
 #include <unistd.h>
 #include <deque>
+#include <algorithm>
 
-Line::Line() : m_Line(0), maxWidthCell(4) {}
+Line::Line() : m_Line(0), m_Pool(nullptr), m_Size(0), m_Count(0), maxWidthCell(4) {}
 
-Line::Line(const Line &src) : maxWidthCell(src.maxWidthCell)
+Line::Line(CellPool *pool) : m_Line(0), m_Pool(pool), m_Size(0), m_Count(0), maxWidthCell(4) {}
+
+Line::Line(const Line &src) : Line(src, src.m_Pool) {}
+
+Line::Line(const Line &src, CellPool *pool) : m_Line(src.m_Line.size(), nullptr), m_Pool(pool), m_Size(src.m_Size), m_Count(src.m_Count), maxWidthCell(src.maxWidthCell)
 {
-    this->m_Line.resize(src.m_Line.size());
     for (size_t i = 0; i < m_Line.size(); i++)
     {
         if (src.m_Line[i] == nullptr)
             continue;
-        if (src.m_Line[i]->whatIs() == "CellFunc")
-        {
-            std::stringstream s;
-            src.m_Line[i]->printFunc(s);
-            this->setFormula((int)i, s.str());
-        }
-        else
-        {
-            std::stringstream s;
-            src.m_Line[i]->print(s);
-            this->setValue((int)i, s.str());
-        }
+        m_Line[i] = m_Pool->allocate();
+        std::copy(src.m_Line[i], src.m_Line[i] + CHUNK_SIZE, m_Line[i]);
     }
 }
 
+Line::Line(Line &&src) noexcept : m_Line(std::move(src.m_Line)), m_Pool(src.m_Pool), m_Size(src.m_Size), m_Count(src.m_Count), maxWidthCell(src.maxWidthCell)
+{
+    src.m_Line.clear();
+    src.m_Size = 0;
+    src.m_Count = 0;
+}
+
+Line &Line::operator=(Line &&src) noexcept
+{
+    std::swap(m_Line, src.m_Line);
+    std::swap(m_Pool, src.m_Pool);
+    std::swap(m_Size, src.m_Size);
+    std::swap(m_Count, src.m_Count);
+    maxWidthCell = src.maxWidthCell;
+    return *this;
+}
+
 Line::~Line()
 {
-    for (size_t i = 0; i < m_Line.size(); i++)
-        delete m_Line[i];
+    if (m_Pool != nullptr)
+        m_Pool->release(m_Line);
+}
+
+Cell &Line::makeCell(const size_t &ind)
+{
+    size_t chunk = ind / CHUNK_SIZE;
+    if (chunk >= m_Line.size())
+        m_Line.resize(chunk + 1, nullptr);
+    if (m_Line[chunk] == nullptr)
+        m_Line[chunk] = m_Pool->allocate();
+    Cell &ret = m_Line[chunk][ind % CHUNK_SIZE];
+    if (ret.isEmpty())
+        m_Count++;
+    if (ind >= m_Size)
+        m_Size = ind + 1;
+    return ret;
 }
 
 size_t Line::getCellWidth(const size_t &ind) const
 {
-    if (m_Line[ind] == nullptr)
+    const Cell *src = this->getCell(ind);
+    if (src == nullptr)
         return maxWidthCell;
-    size_t ret = m_Line[ind]->getLength();
+    size_t ret = src->getLength();
     if (ret == 0 || ret < maxWidthCell)
         return maxWidthCell;
     return ret;
 }
 
-void Line::exportLine(std::ofstream &of) const
-{
-    for (size_t i = 0; i < m_Line.size(); i++)
-    {
-        std::stringstream os;
-        if (m_Line[i] != nullptr)
-            m_Line[i]->print(os);
-        else
-            os << "";
-        if (i == 0)
-        {
-            of << "\"" << os.str() << "\"";
-        }
-        else
-        {
-            of << ",\"" << os.str() << "\"";
-        }
-    }
-}
-
-void Line::exportLineFunc(std::ofstream &of) const
+void Line::exportLine(std::string &buffer, const size_t &width) const
 {
-    for (size_t i = 0; i < m_Line.size(); i++)
+    for (size_t i = 0; i < width; i++)
     {
-        std::stringstream os;
-        if (m_Line[i] != nullptr)
-            m_Line[i]->printFunc(os);
-        else
-            os << "";
-        if (i == 0)
-        {
-            of << "\"" << os.str() << "\"";
-        }
-        else
-        {
-            of << ",\"" << os.str() << "\"";
-        }
+        if (i != 0)
+            buffer += ',';
+        buffer += '"';
+        const Cell *src = this->getCell(i);
+        if (src != nullptr)
+            src->getValue().appendTo(buffer);
+        buffer += '"';
     }
 }
 
-void Line::print(std::ostream &os, const std::vector<size_t> CellWidth) const
+void Line::exportLineFunc(std::string &buffer, const std::vector<Formula> &formulas, const size_t &width, const size_t &row) const
 {
-    if (m_Line.size() > 0)
+    for (size_t i = 0; i < width; i++)
     {
-        os << "|";
-        for (size_t i = 0; i < m_Line.size(); i++)
-        {
-            os << std::setw((int)CellWidth[i]);
-            if (m_Line[i] != nullptr)
-            {
-                m_Line[i]->print(os);
-            }
-            else
-                os << " ";
-            os << "|";
-        }
+        if (i != 0)
+            buffer += ',';
+        buffer += '"';
+        const Cell *src = this->getCell(i);
+        if (src != nullptr && src->getType() == CellType::FORMULA)
+            formulas[src->getFormula()].appendText(buffer, (int)row, (int)i);
+        buffer += '"';
     }
-    os << std::endl;
 }
 
-void Line::printRange(std::ostream &os, const std::vector<size_t> CellWidth, const size_t &column1, const size_t &column2) const
+void Line::appendRange(std::string &buffer, const std::vector<size_t> &CellWidth, const size_t &column1, const size_t &column2) const
 {
-    if (m_Line.size() > 0)
+    buffer += '|';
+    for (size_t i = column1; i <= column2; i++)
     {
-        os << "|";
-        for (size_t i = column1; i <= column2; i++)
-        {
-            os << std::setw((int)CellWidth[i]);
-            if (m_Line[i] != nullptr)
-            {
-                m_Line[i]->print(os);
-            }
-            else
-                os << " ";
-            os << "|";
-        }
+        size_t start = buffer.size();
+        const Cell *src = this->getCell(i);
+        if (src != nullptr)
+            src->getValue().appendTo(buffer);
+        else
+            buffer += ' ';
+        //Cell is aligned to the right, as by std::setw
+        if (buffer.size() - start < CellWidth[i])
+            buffer.insert(start, CellWidth[i] - (buffer.size() - start), ' ');
+        buffer += '|';
     }
-    os << std::endl;
+    buffer += '\n';
 }
 
-void Line::changeSize(const size_t &newWidth)
+size_t Line::getSize() const
 {
-    if (newWidth > m_Line.size())
-    {
-        m_Line.resize(newWidth);
-    }
+    return m_Size;
 }
 
-size_t Line::getSize() const
+bool Line::isEmpty() const
 {
-    return m_Line.size();
+    return m_Count == 0;
 }
 
-bool Line::isEmpty()
+const Cell *Line::getCell(const size_t &ind) const
 {
-    for (size_t i = 0; i < m_Line.size(); i++)
-        if (m_Line[i] != nullptr)
-            return false;
-    return true;
+    size_t chunk = ind / CHUNK_SIZE;
+    if (chunk >= m_Line.size() || m_Line[chunk] == nullptr)
+        return nullptr;
+    const Cell &ret = m_Line[chunk][ind % CHUNK_SIZE];
+    if (ret.isEmpty())
+        return nullptr;
+    return &ret;
 }
 
-Cell *Line::getCell(const size_t &ind) const
+Cell *Line::getCell(const size_t &ind)
 {
-    if (ind >= m_Line.size())
+    size_t chunk = ind / CHUNK_SIZE;
+    if (chunk >= m_Line.size() || m_Line[chunk] == nullptr)
         return nullptr;
-    return m_Line[ind];
+    Cell &ret = m_Line[chunk][ind % CHUNK_SIZE];
+    if (ret.isEmpty())
+        return nullptr;
+    return &ret;
 }
 
-void Line::printFormula(const size_t &row, const size_t &column_min, const size_t &column_max) const
+void Line::appendFormula(std::string &buffer, const size_t &row, const std::vector<Formula> &formulas, const size_t &column_min, const size_t &column_max) const
 {
     size_t max = column_max + 1;
-    if (column_max == 0)
-        max = m_Line.size();
+    if (column_max == 0 || max > m_Size)
+        max = m_Size;
     for (size_t i = column_min; i < max; i++)
     {
-        if (m_Line[i] == nullptr)
-            continue;
-        std::string res = m_Line[i]->whatIs();
-        if (res != "CellFunc")
+        const Cell *src = this->getCell(i);
+        if (src == nullptr || src->getType() != CellType::FORMULA)
             continue;
-        translateRow(std::cout, row + 1, i);
-        std::cout << " = ";
-        m_Line[i]->printFunc(std::cout);
-        std::cout << std::endl;
+        std::string name = cellName((int)row, (int)i);
+        std::transform(name.begin(), name.end(), name.begin(), ::toupper);
+        buffer += name;
+        buffer += " = ";
+        formulas[src->getFormula()].appendText(buffer, (int)row, (int)i);
+        buffer += '\n';
     }
 }
 
@@ -191,109 +189,77 @@ void Line::setValue(const int &ind, const std::string &newValue)
 {
     if (isNum(newValue))
     {
-        NumCell *newCell = new NumCell();
         double value = stod(newValue);
-        newCell->setValue(value);
-        if (m_Line[ind] == nullptr)
-            m_Line[ind] = newCell;
-        else
-        {
-            delete m_Line[ind];
-            m_Line[ind] = newCell;
-        }
+        this->makeCell(ind).setNumber(value);
     }
     else
     {
-        StringCell *newCell = new StringCell();
-        newCell->setValue(newValue);
-        if (m_Line[ind] == nullptr)
-            m_Line[ind] = newCell;
-        else
-        {
-            delete m_Line[ind];
-            m_Line[ind] = newCell;
-        }
+        this->makeCell(ind).setString(newValue);
     }
 }
 
-void Line::setFormula(const int &column, const std::string &src)
+void Line::setCell(const int &ind, const Cell &src)
 {
-    if (m_Line[column] != nullptr)
-        delete m_Line[column];
-    CellFunc *newCell = new CellFunc();
-    newCell->setFormula(src);
-    m_Line[column] = newCell;
+    if (src.isEmpty())
+        return;
+    this->makeCell(ind) = src;
+}
+
+void Line::setFormula(const int &column, const int &index)
+{
+    this->makeCell(column).setFormula(index);
 }
 
 void Line::delEmpty()
 {
-    for (int i = (int)m_Line.size() - 1; i >= 0; i--)
-    {
-        if (m_Line[i] == nullptr)
-            m_Line.erase(m_Line.begin() + i);
-        else
-            break;
-    }
+    while (m_Size > 0 && this->getCell(m_Size - 1) == nullptr)
+        m_Size--;
+    //Chunks after last not empty Cell are not needed
+    size_t chunks = (m_Size + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    for (size_t i = chunks; i < m_Line.size(); i++)
+        if (m_Line[i] != nullptr)
+            m_Pool->release(m_Line[i]);
+    m_Line.resize(chunks);
 }
 
 void Line::delCell(const int &ind)
 {
-    if (m_Line[ind] == nullptr)
+    Cell *src = this->getCell(ind);
+    if (src == nullptr)
         return;
 
-    delete m_Line[ind];
-    m_Line[ind] = nullptr;
+    src->clear();
+    m_Count--;
     this->delEmpty();
 }
 
-void Line::setValueFormula(const int &ind, const std::string &newValue)
+bool Line::hasFormula() const
 {
-    CellFunc *newCell = new CellFunc();
-    try
-    {
-        newCell->setFormula(newValue);
-    }
-    catch (const std::exception &ex)
+    for (size_t i = 0; i < m_Size; i++)
     {
-        delete newCell;
-        throw std::logic_error(ex.what());
+        const Cell *src = this->getCell(i);
+        if (src != nullptr && src->getType() == CellType::FORMULA)
+            return true;
     }
-
-    if (m_Line[ind] != nullptr)
-        delete m_Line[ind];
-    m_Line[ind] = newCell;
+    return false;
 }
 
-bool Line::hasFormula() const
+ColumnWidth::ColumnWidth() {}
+
+void ColumnWidth::change(const size_t &oldLength, const size_t &length)
 {
-    for (size_t i = 0; i < m_Line.size(); i++)
-        if (m_Line[i] != nullptr)
-        {
-            std::string res = m_Line[i]->whatIs();
-            if (res == "CellFunc")
-                return true;
-        }
-    return false;
+    if (oldLength == length)
+        return;
+    auto old = m_Counts.find(oldLength);
+    if (oldLength != 0 && old != m_Counts.end() && --old->second == 0)
+        m_Counts.erase(old);
+    if (length != 0)
+        m_Counts[length]++;
 }
 
-std::vector<int> Line::deleteDepend(const std::string &childCell)
+size_t ColumnWidth::getWidth() const
 {
-    std::vector<int> ret;
-    for (size_t i = 0; i < m_Line.size(); i++)
-    {
-        if (m_Line[i] == nullptr)
-            continue;
-        std::vector<std::string> formula = m_Line[i]->getFormula();
-        for (size_t j = 0; j < formula.size(); j++)
-        {
-            if (formula[j] == childCell)
-            {
-                ret.push_back((int)i);
-                break;
-            }
-        }
-    }
-    return ret;
+    return m_Counts.empty() ? 0 : m_Counts.rbegin()->first;
 }
 
-#endif // LINE_CPP
\ No newline at end of file
+#endif // LINE_CPP
@@ -1,7 +1,7 @@
 /**
  * @file line.h
  * @author Daria Tiurina (tiuridar@fit.cvut.cz)
- * @brief Declaration of class Line
+ * @brief Declaration of class Line and class ColumnWidth
  * @version 0.9
  * @date 2023-05-12
  *
@@ -12,73 +12,90 @@
 #define LINE_H
 
 #include <vector>
+#include <cstdint>
+#include <map>
 #include "../cell/cell.h"
+#include "../pool/pool.h"
 #include <iostream>
 #include <fstream>
 
 /**
- * @brief Class Line which defines 1 line in a class Tables
+ * @brief Class Line which defines 1 line in a class Tables. Cells are stored in chunks, which are allocated from a CellPool of a table on first write and returned to it, when Line is destroyed
  */
 class Line
 {
 public:
     /**
-     * @brief Construct a new Line object
+     * @brief Construct a new Line object, which cannot be written to
      */
     Line();
 
     /**
-     * @brief Construct a new Line object copied from a source Line
+     * @brief Construct a new empty Line object
+     * @param pool CellPool, from which chunks of Cells are allocated
+     */
+    Line(CellPool *pool);
+
+    /**
+     * @brief Construct a new Line object copied from a source Line. Chunks are allocated from the same CellPool
      * @param src source Line, which is needed to be copied from
      */
     Line(const Line &src);
 
     /**
-     * @brief Destroy the Line object
+     * @brief Construct a new Line object copied from a source Line
+     * @param src source Line, which is needed to be copied from
+     * @param pool CellPool, from which chunks of Cells are allocated
      */
-    ~Line();
+    Line(const Line &src, CellPool *pool);
 
     /**
-     * @brief Changes width of a Line
-     * @param newWidth width, which will be set
+     * @brief Construct a new Line object by taking Cells from a source Line
+     * @param src source Line, which will be left empty
      */
-    void changeSize(const size_t &newWidth);
+    Line(Line &&src) noexcept;
 
     /**
-     * @brief Get the Cell object
-     * @param ind where Cell is situated
-     * @return Cell* needed Cell
+     * @brief Takes Cells from a source Line
+     * @param src source Line, which will be left with previous Cells of this Line
+     * @return Line& this Line
      */
-    Cell *getCell(const size_t &ind) const;
+    Line &operator=(Line &&src) noexcept;
 
     /**
-     * @brief Print full Line to a given std::ostream
-     * @param os std::ostream, where Line will be printed
-     * @param CellWidth std::vector<size_t> with maxWidth of every Column
+     * @brief Destroy the Line object
      */
-    void print(std::ostream &os, const std::vector<size_t> CellWidth) const;
+    ~Line();
 
     /**
-     * @brief Print givenRange Line to a given std::ostream
-     * @param os std::ostream, where Line will be printed
-     * @param CellWidth std::vector<size_t> with maxWidth of every Column
-     * @param column1 starting Range column
-     * @param column2 ending Range column
+     * @brief Get the Cell object
+     * @param ind where Cell is situated
+     * @return const Cell* needed Cell or nullptr if Cell is empty
      */
-    void printRange(std::ostream &os, const std::vector<size_t> CellWidth, const size_t &column1, const size_t &column2) const;
+    const Cell *getCell(const size_t &ind) const;
 
     /**
-     * @brief Export Line to a given std::ofstream
-     * @param of std::ofstream where Line will be exported to
+     * @brief Get the Cell object
+     * @param ind where Cell is situated
+     * @return Cell* needed Cell or nullptr if Cell is empty
      */
-    void exportLine(std::ofstream &of) const;
+    Cell *getCell(const size_t &ind);
 
     /**
-     * @brief exports formula
-     * 
-     * @param of file, where formula will be exported
+     * @brief Appends Line's data in CSV format to a buffer
+     * @param buffer line, where Line's data will be appended
+     * @param width number of columns, which will be written
+     */
+    void exportLine(std::string &buffer, const size_t &width) const;
+
+    /**
+     * @brief Appends Line's formulas in CSV format to a buffer
+     * @param buffer line, where Line's formulas will be appended
+     * @param formulas Formulas of a table, which Cells reference
+     * @param width number of columns, which will be written
+     * @param row row, in which line is in
      */
-    void exportLineFunc(std::ofstream &of) const;
+    void exportLineFunc(std::string &buffer, const std::vector<Formula> &formulas, const size_t &width, const size_t &row) const;
 
     /**
      * @brief change maxWidth size parametr
@@ -87,12 +104,12 @@ public:
     void changeSizeCell(const size_t &newSize);
 
     /**
-     * @brief Sets the CellFunc
+     * @brief Makes a Cell formula
      * 
-     * @param column index, where CellFunc will be set
-     * @param src line which will be set as formula
+     * @param column index, where formula will be set
+     * @param index index of a Formula in a table
      */
-    void setFormula(const int & column, const std::string & src);
+    void setFormula(const int &column, const int &index);
 
     /**
      * @brief Delete Cell from a Line
@@ -105,7 +122,7 @@ public:
      * @return true Line is empty
      * @return false Line has at least one not empty Cell
      */
-    bool isEmpty();
+    bool isEmpty() const;
 
     /**
      * @brief Delete all empty columns at the back of a Line
@@ -120,17 +137,28 @@ public:
     size_t getCellWidth(const size_t &ind) const;
 
     /**
-     * @brief print formula containing in Cell
+     * @brief Appends formulas containing in Cells to a given buffer, one formula on a line
      * 
+     * @param buffer line, where formulas will be appended
      * @param row row, in which line is in
+     * @param formulas Formulas of a table, which Cells reference
      * @param column_min from which column start
-     * @param column_max on which column end
+     * @param column_max on which column end, 0 means till the end of a Line
      */
-    void printFormula(const size_t & row, const size_t & column_min = 0, const size_t & column_max = 0) const;
+    void appendFormula(std::string &buffer, const size_t &row, const std::vector<Formula> &formulas, const size_t &column_min = 0, const size_t &column_max = 0) const;
+
+    /**
+     * @brief Appends Cells from column1 to column2 to a given buffer in the same way, as they are printed in a table
+     * @param buffer line, where Cells will be appended
+     * @param CellWidth std::vector<size_t> with maxWidth of every Column
+     * @param column1 first appended column
+     * @param column2 last appended column
+     */
+    void appendRange(std::string &buffer, const std::vector<size_t> &CellWidth, const size_t &column1, const size_t &column2) const;
 
     /**
      * @brief Return size of a Line
-     * @return size_t number of columns in a Line
+     * @return size_t number of columns till last not empty Cell in a Line
      */
     size_t getSize() const;
 
@@ -142,35 +170,76 @@ public:
     void setValue(const int &ind, const std::string &newValue);
 
     /**
-     * @brief Set the formula
-     * 
-     * @param ind index where CellFunc will be
-     * @param newValue formula which will be set
-     */
-    void setValueFormula(const int &ind, const std::string &newValue);
-
-    /**
-     * @brief return indexes of depended cells
-     * 
-     * @param childCell which child cell needs to be find in formulas
-     * @return std::vector<int> vector of indexes
+     * @brief Sets already made Cell to a given index
+     * @param ind Index of needed Cell
+     * @param src Cell, which will be copied
      */
-    std::vector<int> deleteDepend(const std::string &childCell);
+    void setCell(const int &ind, const Cell &src);
 
     /**
      * @brief Returns whether line has formulas
      * 
-     * @return true line has at least 1 CellFunc
-     * @return false line doesn't have ane CellFunc
+     * @return true line has at least 1 formula
+     * @return false line doesn't have any formula
      */
     bool hasFormula() const;
 
+    //!> number of Cells in one chunk
+    static const size_t CHUNK_SIZE = CellPool::CHUNK_SIZE;
+
 private:
-    //!> std::vector of pointers to Cells
+    //!> chunks of Cells, not allocated chunk is nullptr
     std::vector<Cell *> m_Line;
 
+    //!> CellPool, from which chunks are allocated
+    CellPool *m_Pool;
+
+    //!> number of columns till last not empty Cell
+    size_t m_Size;
+
+    //!> number of not empty Cells
+    size_t m_Count;
+
     //!> const maxWidthCell, which is used while printing Line
     size_t maxWidthCell;
+
+    /**
+     * @brief Get the Cell, which will be written to. Allocates chunk if it is needed
+     * @param ind index of a Cell
+     * @return Cell& needed Cell
+     */
+    Cell &makeCell(const size_t &ind);
+};
+
+/**
+ * @brief Class ColumnWidth, widths of printed Cells of one column. Only number of Cells with every width is saved, width of a column is the biggest width with at least one Cell
+ *
+ */
+class ColumnWidth
+{
+public:
+    /**
+     * @brief Construct a new empty ColumnWidth object
+     */
+    ColumnWidth();
+
+    /**
+     * @brief Saves new width of a changed Cell
+     *
+     * @param oldLength number of symbols of a printed Cell before the change, 0 if Cell was empty
+     * @param length number of symbols of a printed Cell, 0 if Cell is empty
+     */
+    void change(const size_t &oldLength, const size_t &length);
+
+    /**
+     * @brief Get the width of a column
+     * @return size_t number of symbols of the widest Cell in a column
+     */
+    size_t getWidth() const;
+
+private:
+    //!> number of Cells with every width, empty Cells and widths without Cells are not saved
+    std::map<size_t, size_t> m_Counts;
 };
 
 #endif // LINE_H
@@ -12,10 +12,67 @@
 #include "execute/execute.h"
 #include "tables/tables.h"
 #include "commands/commands.h"
+#include "help/help.h"
+#include <string>
+#include <fstream>
+#include <stdexcept>
 
-int main()
+int main(int argc, char **argv)
 {
+    bool script = false;
+    std::string scriptName;
+    //Number of threads for counting formulas and import can be given as "--threads N"
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "--threads" && i + 1 < argc)
+        {
+            try
+            {
+                //Number must be positive, negative number is not wrapped to a huge one
+                std::string count = argv[++i];
+                size_t end = 0;
+                long number = std::stol(count, &end);
+                if (end != count.size() || number <= 0)
+                    throw std::logic_error("Wrong number of threads");
+                setThreadCount((size_t)number);
+            }
+            catch (const std::exception &ex)
+            {
+                std::cout << "|-> ERROR DETECTED: Wrong number of threads" << std::endl;
+                return EXIT_FAILURE;
+            }
+        }
+        //Commands are read from a file given as "--script FILE" or from standard input, if file is not given
+        else if (arg == "--script")
+        {
+            script = true;
+            if (i + 1 < argc && std::string(argv[i + 1]).rfind("--", 0) != 0)
+                scriptName = argv[++i];
+        }
+        else
+        {
+            std::cout << "|-> ERROR DETECTED: Unknown argument " << arg << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
     Tables t;
+    if (script)
+    {
+        if (scriptName.empty())
+        {
+            return Execute::runScript(std::cin, t) ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+        std::ifstream input(scriptName);
+        if (!input.is_open())
+        {
+            std::cout << "|-> ERROR DETECTED: Script cannot be open" << std::endl;
+            return EXIT_FAILURE;
+        }
+        return Execute::runScript(input, t) ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
     Commands c;
     while (true)
     {
@@ -59,7 +59,7 @@ void Operators::convertLine(const std::string &src)
                 }
                 if (!m_Stack.empty())
                 {
-                    if (m_Stack.top().first == "sin" || m_Stack.top().first == "cos" || m_Stack.top().first == "sqrt")
+                    if (isFunc(m_Stack.top().first))
                     {
                         m_Numbers.push_back(m_Stack.top().first);
                         m_Stack.pop();
@@ -124,6 +124,109 @@ void Operators::convertLine(const std::string &src)
         m_Numbers.push_back(m_Stack.top().first);
         m_Stack.pop();
     }
+    this->compile();
+}
+
+void Operators::compile()
+{
+    m_Bytecode = Bytecode();
+    size_t depth = 0;
+    for (size_t i = 0; i < m_Numbers.size(); i++)
+    {
+        const std::string &token = m_Numbers[i];
+        Instruction ins = {OpCode::STRING, 0, 0, 0, 0, -1, 0};
+        if (isOperation(token))
+        {
+            if (token == "+")
+                ins.op = OpCode::ADD;
+            else if (token == "-")
+                ins.op = OpCode::SUB;
+            else if (token == "*")
+                ins.op = OpCode::MUL;
+            else if (token == "/")
+                ins.op = OpCode::DIV;
+            else if (token == "sin")
+                ins.op = OpCode::SIN;
+            else if (token == "cos")
+                ins.op = OpCode::COS;
+            else if (token == "sqrt")
+                ins.op = OpCode::SQRT;
+            else if (token == "sum")
+                ins.op = OpCode::SUM;
+            else if (token == "avg")
+                ins.op = OpCode::AVG;
+            else if (token == "min")
+                ins.op = OpCode::MIN;
+            else if (token == "max")
+                ins.op = OpCode::MAX;
+            else
+                ins.op = OpCode::COUNT;
+
+            if (isAggregate(token))
+            {
+                //Aggregate function takes place of a range (or one cell) right before it
+                if (m_Bytecode.code.empty() || (m_Bytecode.code.back().op != OpCode::RANGE && m_Bytecode.code.back().op != OpCode::CELL))
+                    throw std::logic_error("Not correct formula");
+                m_Bytecode.code.back().op = ins.op;
+                continue;
+            }
+
+            //Missing operands are completed while executing, so stack may not be deep enough
+            if (isFunc(token))
+                depth = std::max(depth, (size_t)1);
+            else if (depth > 1)
+                depth--;
+            m_Bytecode.code.push_back(ins);
+            m_Bytecode.maxStack = std::max(m_Bytecode.maxStack, depth);
+            continue;
+        }
+
+        std::string lower = token;
+        std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+        ins.text = (int)m_Bytecode.strings.size();
+        if (detectIfIsCell(lower))
+        {
+            std::pair<int, int> cord = translateCell(lower);
+            ins.op = OpCode::CELL;
+            ins.row = ins.rowEnd = cord.first;
+            ins.column = ins.columnEnd = cord.second;
+            m_Bytecode.strings.push_back(lower);
+        }
+        else if (detectIfIsRange(lower))
+        {
+            std::pair<int, int> cord1 = translateCell(lower.substr(0, lower.find(':')));
+            std::pair<int, int> cord2 = translateCell(lower.substr(lower.find(':') + 1));
+            ins.op = OpCode::RANGE;
+            ins.row = std::min(cord1.first, cord2.first);
+            ins.column = std::min(cord1.second, cord2.second);
+            ins.rowEnd = std::max(cord1.first, cord2.first);
+            ins.columnEnd = std::max(cord1.second, cord2.second);
+            m_Bytecode.strings.push_back(lower);
+        }
+        else if (isNum(token))
+        {
+            ins.op = OpCode::NUMBER;
+            try
+            {
+                ins.number = std::stod(token);
+            }
+            catch (const std::exception &ex)
+            {
+                throw std::logic_error("Not correct formula");
+            }
+            ins.text = -1;
+        }
+        else
+            m_Bytecode.strings.push_back(token);
+        m_Bytecode.code.push_back(ins);
+        depth++;
+        m_Bytecode.maxStack = std::max(m_Bytecode.maxStack, depth);
+    }
+
+    //Range can be used only inside an aggregate function
+    for (size_t i = 0; i < m_Bytecode.code.size(); i++)
+        if (m_Bytecode.code[i].op == OpCode::RANGE)
+            throw std::logic_error("Not correct formula");
 }
 
 std::vector<std::string> Operators::returnLine()
@@ -131,4 +234,9 @@ std::vector<std::string> Operators::returnLine()
     return m_Numbers;
 }
 
+Bytecode Operators::returnBytecode()
+{
+    return m_Bytecode;
+}
+
 #endif
\ No newline at end of file
@@ -15,7 +15,75 @@
 #include <string>
 
 /**
- * @brief Class which converts formula to RPN
+ * @brief Operation codes of a compiled formula
+ *
+ */
+enum class OpCode : unsigned char
+{
+    NUMBER, //!< pushes number constant
+    STRING, //!< pushes string constant
+    CELL,   //!< pushes value of a referenced cell
+    ADD,    //!< adds two values
+    SUB,    //!< subtracts two values
+    MUL,    //!< multiplies two values
+    DIV,    //!< divides two values
+    SIN,    //!< sinus of a value
+    COS,    //!< cosinus of a value
+    SQRT,   //!< square root of a value
+    RANGE,  //!< range of cells, exists only while compiling, aggregate function takes its place
+    SUM,    //!< sum of numbers in a range
+    AVG,    //!< average of numbers in a range
+    MIN,    //!< minimum of numbers in a range
+    MAX,    //!< maximum of numbers in a range
+    COUNT   //!< number of numbers in a range
+};
+
+/**
+ * @brief One instruction of a compiled formula
+ *
+ */
+struct Instruction
+{
+    //!> what instruction does
+    OpCode op;
+
+    //!> row of a referenced cell or first row of a range
+    int row;
+
+    //!> column of a referenced cell or first column of a range
+    int column;
+
+    //!> last row of a range
+    int rowEnd;
+
+    //!> last column of a range
+    int columnEnd;
+
+    //!> index of a constant's text or a cell's name in Bytecode::strings
+    int text;
+
+    //!> number constant
+    double number;
+};
+
+/**
+ * @brief Formula compiled from RPN with already parsed constants and cell references
+ *
+ */
+struct Bytecode
+{
+    //!> instructions in order of execution
+    std::vector<Instruction> code;
+
+    //!> texts of constants and names of referenced cells
+    std::vector<std::string> strings;
+
+    //!> max number of values on a stack while executing
+    size_t maxStack = 0;
+};
+
+/**
+ * @brief Class which converts formula to RPN and compiles it to Bytecode
  *
  */
 class Operators
@@ -47,10 +115,26 @@ public:
      */
     std::vector<std::string> returnLine();
 
+    /**
+     * @brief returns compiled formula
+     *
+     * @return Bytecode formula compiled from RPN
+     */
+    Bytecode returnBytecode();
+
 private:
     
     //!> result of convertion in RPN
     std::vector<std::string> m_Numbers;
+
+    //!> result of compilation of RPN
+    Bytecode m_Bytecode;
+
+    /**
+     * @brief Compiles formula in RPN to Bytecode
+     *
+     */
+    void compile();
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,64 @@
+/**
+ * @file pool.cpp
+ * @author Daria Tiurina (tiuridar@fit.cvut.cz)
+ * @brief Implementation of class CellPool
+ * @version 1.0
+ * @date 2023-06-05
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+#ifndef POOL_CPP
+#define POOL_CPP
+#include "pool.h"
+
+CellPool::CellPool() : m_Slabs(), m_Used(SLAB_CHUNKS), m_Free() {}
+
+CellPool::~CellPool() {}
+
+Cell *CellPool::allocate()
+{
+    Cell *ret = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(m_Lock);
+        if (m_Free.empty())
+        {
+            if (m_Used == SLAB_CHUNKS)
+            {
+                m_Slabs.emplace_back(new Cell[SLAB_CHUNKS * CHUNK_SIZE]);
+                m_Used = 0;
+            }
+            return m_Slabs.back().get() + CHUNK_SIZE * m_Used++;
+        }
+        ret = m_Free.back();
+        m_Free.pop_back();
+    }
+    //Released chunk is cleared outside of a lock
+    for (size_t i = 0; i < CHUNK_SIZE; i++)
+        ret[i].clear();
+    return ret;
+}
+
+void CellPool::release(Cell *chunk)
+{
+    std::lock_guard<std::mutex> lock(m_Lock);
+    m_Free.push_back(chunk);
+}
+
+void CellPool::release(const std::vector<Cell *> &chunks)
+{
+    std::lock_guard<std::mutex> lock(m_Lock);
+    for (size_t i = 0; i < chunks.size(); i++)
+        if (chunks[i] != nullptr)
+            m_Free.push_back(chunks[i]);
+}
+
+void CellPool::clear()
+{
+    std::lock_guard<std::mutex> lock(m_Lock);
+    m_Slabs.clear();
+    m_Free.clear();
+    m_Used = SLAB_CHUNKS;
+}
+
+#endif // POOL_CPP
@@ -0,0 +1,89 @@
+/**
+ * @file pool.h
+ * @author Daria Tiurina (tiuridar@fit.cvut.cz)
+ * @brief Declaration of class CellPool
+ * @version 1.0
+ * @date 2023-06-05
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+#ifndef POOL_H
+#define POOL_H
+
+#include <vector>
+#include <memory>
+#include <mutex>
+#include "../cell/cell.h"
+
+/**
+ * @brief Class CellPool, which allocates chunks of Cells for Lines of one table. Chunks are cut from big slabs and released chunks are reused
+ *
+ */
+class CellPool
+{
+public:
+    /**
+     * @brief Construct a new empty CellPool object
+     */
+    CellPool();
+
+    /**
+     * @brief CellPool cannot be copied, Lines reference its chunks
+     */
+    CellPool(const CellPool &src) = delete;
+
+    /**
+     * @brief CellPool cannot be copied, Lines reference its chunks
+     */
+    CellPool &operator=(const CellPool &src) = delete;
+
+    /**
+     * @brief Destroy the CellPool object with all its chunks
+     */
+    ~CellPool();
+
+    /**
+     * @brief Get the chunk of empty Cells. Can be called from multiple threads
+     * @return Cell* first of CHUNK_SIZE Cells
+     */
+    Cell *allocate();
+
+    /**
+     * @brief Returns chunk, so it can be used again. Cells are cleared, when chunk is allocated again
+     * @param chunk chunk, which was allocated from this CellPool
+     */
+    void release(Cell *chunk);
+
+    /**
+     * @brief Returns several chunks at once. Can be called from multiple threads
+     * @param chunks chunks, which were allocated from this CellPool, nullptr is skipped
+     */
+    void release(const std::vector<Cell *> &chunks);
+
+    /**
+     * @brief Frees all chunks at once. Chunks allocated before are not valid anymore
+     */
+    void clear();
+
+    //!> number of Cells in one chunk
+    static const size_t CHUNK_SIZE = 16;
+
+    //!> number of chunks in one slab
+    static const size_t SLAB_CHUNKS = 256;
+
+private:
+    //!> slabs, which chunks are cut from
+    std::vector<std::unique_ptr<Cell[]>> m_Slabs;
+
+    //!> number of chunks already cut from the last slab
+    size_t m_Used;
+
+    //!> released chunks, which are used before cutting new ones
+    std::vector<Cell *> m_Free;
+
+    //!> lock, so Lines can be filled by several threads
+    std::mutex m_Lock;
+};
+
+#endif // POOL_H
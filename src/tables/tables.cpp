@@ -14,6 +14,7 @@
 #include "../line/line.h"
 #include "../graph/graph.h"
 #include "../help/help.h"
+#include "../aggregate/aggregate.h"
 #include <iostream>
 #include <sstream>
 #include <string>
@@ -21,177 +22,1084 @@
 #include <fstream>
 #include <limits>
 #include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
 #include <unistd.h>
 #include <algorithm>
 #include <deque>
+#include <cerrno>
+#include <charconv>
 #include <cmath>
+#include <cstring>
+#include <functional>
+#include <unordered_map>
+#include <unordered_set>
 
-Tables::Tables() : m_Table(0), maxLineSize(0) {}
+Tables::Tables() : m_Table(0), m_Pool(std::make_shared<CellPool>()), m_Rows(0), maxLineSize(0), m_Formula(std::make_shared<std::vector<std::pair<int, int>>>()),
+                   m_FormulaIndex(std::make_shared<std::unordered_map<uint64_t, size_t>>()), m_Formulas(std::make_shared<std::vector<Formula>>()),
+                   m_FreeFormulas(std::make_shared<std::vector<int>>()), m_References(std::make_shared<std::unordered_map<uint64_t, std::vector<std::pair<int, int>>>>()),
+                   m_Dependents(std::make_shared<std::unordered_map<uint64_t, std::unordered_set<uint64_t>>>()), m_Dirty(std::make_shared<std::unordered_set<uint64_t>>()),
+                   m_Deferred(false), m_RangeDependents(std::make_shared<std::unordered_map<int, std::vector<RangeReference>>>()) {}
 
-Tables::Tables(const Tables &src) : m_Table(src.m_Table) {}
+//Blocks of Lines, columns and structures of formulas are shared, they are copied only when one of tables changes them
+Tables::Tables(const Tables &src) = default;
 
-Tables::~Tables() {}
+//Old Lines are released before CellPool is changed, because m_Table is declared before m_Pool
+Tables &Tables::operator=(const Tables &src) = default;
+
+Tables &Tables::operator=(Tables &&src) = default;
+
+Tables::~Tables()
+{
+    //Lines are released while their CellPool exists
+    m_Table.clear();
+}
 
 void Tables::changeSize(const int &newSize)
 {
-    if ((size_t)newSize > m_Table.size())
-    {
-        m_Table.resize(newSize);
-    }
-    this->changeLineSize((int)maxLineSize);
+    if ((size_t)newSize > m_Rows)
+        m_Rows = newSize;
 }
 
 void Tables::changeLineSize(const int &newSize)
 {
     if ((int)maxLineSize < newSize)
         maxLineSize = newSize;
-    for (size_t i = 0; i < m_Table.size(); i++)
+}
+
+const Line *Tables::findLine(const int &row) const
+{
+    if (row < 0 || (size_t)row >= m_Rows)
+        return nullptr;
+    size_t block = (size_t)row / BLOCK_SIZE;
+    if (block >= m_Table.size() || m_Table[block] == nullptr)
+        return nullptr;
+    return &(*m_Table[block])[(size_t)row % BLOCK_SIZE];
+}
+
+Line *Tables::editLine(const int &row)
+{
+    if (row < 0 || (size_t)row >= m_Rows)
+        return nullptr;
+    size_t block = (size_t)row / BLOCK_SIZE;
+    if (block >= m_Table.size() || m_Table[block] == nullptr)
+        return nullptr;
+    return &this->makeBlock(block)[(size_t)row % BLOCK_SIZE];
+}
+
+std::vector<Line> &Tables::makeBlock(const size_t &block)
+{
+    std::shared_ptr<std::vector<Line>> &ret = m_Table[block];
+    if (ret == nullptr)
     {
-        m_Table[i].changeSize(newSize);
+        ret = std::make_shared<std::vector<Line>>();
+        ret->reserve(BLOCK_SIZE);
+        for (size_t i = 0; i < BLOCK_SIZE; i++)
+            ret->emplace_back(m_Pool.get());
     }
+    else if (ret.use_count() > 1)
+        ret = std::make_shared<std::vector<Line>>(*ret);
+    return *ret;
 }
 
-void Tables::setValue(const int &row, const int &column, const std::string &input)
+Line &Tables::makeLine(const int &row)
 {
     this->changeSize(row + 1);
+    size_t block = (size_t)row / BLOCK_SIZE;
+    if (block >= m_Table.size())
+        m_Table.resize(block + 1);
+    return this->makeBlock(block)[(size_t)row % BLOCK_SIZE];
+}
+
+void Tables::setValue(const int &row, const int &column, const std::string &input)
+{
     this->changeLineSize(column + 1);
-    Cell *newCell = m_Table[row].getCell(column);
-    if (newCell != nullptr)
+    size_t length = this->cellLength(row, column);
+    this->releaseFormula(row, column);
+    this->makeLine(row).setValue(column, input);
+    this->updateIndex(row, column, length);
+    this->markDirty(row, column);
+}
+
+bool Tables::sameFormula(const Formula &shared, const Formula &newFormula, const int &row, const int &column)
+{
+    if (shared.code.code.size() != newFormula.code.code.size() || shared.code.strings.size() != newFormula.code.strings.size() || shared.code.maxStack != newFormula.code.maxStack)
+        return false;
+    for (size_t i = 0; i < shared.code.code.size(); i++)
+    {
+        Instruction moved = shared.instruction(i, row, column);
+        const Instruction &ins = newFormula.code.code[i];
+        if (moved.op != ins.op || moved.row != ins.row || moved.column != ins.column || moved.rowEnd != ins.rowEnd || moved.columnEnd != ins.columnEnd || moved.text != ins.text || moved.number != ins.number)
+            return false;
+        //Names of referenced Cells are different, they are compared as a part of a text
+        if (ins.op == OpCode::STRING && shared.code.strings[ins.text] != newFormula.code.strings[ins.text])
+            return false;
+    }
+    std::string text;
+    shared.appendText(text, row, column);
+    return text == newFormula.text;
+}
+
+int Tables::storeFormula(Formula &&newFormula, const int &row, const int &column)
+{
+    //Formula filled down a column is saved once and shared with a Cell above
+    const Cell *above = this->findCell(row - 1, column);
+    if (above != nullptr && above->getType() == CellType::FORMULA && Tables::sameFormula((*m_Formulas)[above->getFormula()], newFormula, row, column))
+    {
+        Tables::editShared(m_Formulas)[above->getFormula()].users++;
+        return above->getFormula();
+    }
+
+    newFormula.row = row;
+    newFormula.column = column;
+    newFormula.users = 1;
+    std::vector<Formula> &formulas = Tables::editShared(m_Formulas);
+    if (m_FreeFormulas->empty())
+    {
+        formulas.push_back(std::move(newFormula));
+        return (int)formulas.size() - 1;
+    }
+    std::vector<int> &freeFormulas = Tables::editShared(m_FreeFormulas);
+    int index = freeFormulas.back();
+    freeFormulas.pop_back();
+    formulas[index] = std::move(newFormula);
+    return index;
+}
+
+Formula Tables::compileFormula(const std::string &src)
+{
+    Operators op;
+    try
+    {
+        op.convertLine(src);
+    }
+    catch (const std::exception &ex)
+    {
+        throw std::logic_error(ex.what());
+    }
+
+    Formula newFormula;
+    newFormula.text = src;
+    newFormula.code = op.returnBytecode();
+    return newFormula;
+}
+
+void Tables::releaseFormula(const int &row, const int &column)
+{
+    const Cell *src = this->findCell(row, column);
+    if (src == nullptr || src->getType() != CellType::FORMULA)
+        return;
+
+    this->unlinkFormula(row, column);
+    if (m_Dirty->count(Tables::cellKey(row, column)) != 0)
+        Tables::editShared(m_Dirty).erase(Tables::cellKey(row, column));
+    //Formula is removed only after the last Cell, which shares it
+    std::vector<Formula> &formulas = Tables::editShared(m_Formulas);
+    if (--formulas[src->getFormula()].users != 0)
+        return;
+    formulas[src->getFormula()] = Formula();
+    Tables::editShared(m_FreeFormulas).push_back(src->getFormula());
+}
+
+/**
+ * @brief Helping function, which detects if instruction is an aggregate function over a range
+ *
+ * @param op operation's code
+ * @return true instruction reads a range
+ * @return false instruction doesn't read a range
+ */
+static bool isAggregateOp(const OpCode &op)
+{
+    return op == OpCode::SUM || op == OpCode::AVG || op == OpCode::MIN || op == OpCode::MAX || op == OpCode::COUNT;
+}
+
+template <typename T>
+T &Tables::editShared(std::shared_ptr<T> &column)
+{
+    if (column == nullptr)
+        column = std::make_shared<T>();
+    else if (column.use_count() > 1)
+        column = std::make_shared<T>(*column);
+    return *column;
+}
+
+size_t Tables::cellLength(const int &row, const int &column) const
+{
+    const Cell *src = this->findCell(row, column);
+    return src != nullptr ? src->getLength() : 0;
+}
+
+void Tables::updateIndex(const int &row, const int &column, const size_t &oldLength)
+{
+    static const Value empty;
+    const Cell *src = this->findCell(row, column);
+    const Value &value = src != nullptr ? src->getValue() : empty;
+    if ((size_t)column >= m_Columns.size())
+        m_Columns.resize((size_t)column + 1);
+    Tables::editShared(m_Columns[column]).set((size_t)row, value);
+    if ((size_t)column >= m_Widths.size())
+        m_Widths.resize((size_t)column + 1);
+    Tables::editShared(m_Widths[column]).change(oldLength, src != nullptr ? src->getLength() : 0);
+    //Index, which is not built yet, is built later from the whole column
+    auto index = m_ColumnIndex.find(column);
+    if (index != m_ColumnIndex.end() && index->second != nullptr)
+        Tables::editShared(index->second).update((size_t)row, *m_Columns[column]);
+}
+
+void Tables::buildIndexes()
+{
+    for (auto it = m_ColumnIndex.begin(); it != m_ColumnIndex.end(); it++)
+    {
+        if (it->second != nullptr)
+            continue;
+        if ((size_t)it->first < m_Columns.size() && m_Columns[it->first] != nullptr)
+            it->second = std::make_shared<ColumnIndex>(*m_Columns[it->first]);
+        else
+            it->second = std::make_shared<ColumnIndex>();
+    }
+}
+
+void Tables::buildColumns()
+{
+    m_Columns.resize(maxLineSize);
+    for (size_t i = 0; i < m_Columns.size(); i++)
+        m_Columns[i] = std::make_shared<NumberColumn>();
+    m_Widths.resize(maxLineSize);
+    for (size_t i = 0; i < m_Widths.size(); i++)
+        m_Widths[i] = std::make_shared<ColumnWidth>();
+    //Indexes are built again from new columns
+    for (auto it = m_ColumnIndex.begin(); it != m_ColumnIndex.end(); it++)
+        it->second = nullptr;
+    //Every thread fills its own columns
+    parallelFor(m_Columns.size(), 1, [this](size_t begin, size_t end) {
+        for (size_t i = 0; i < m_Rows; i++)
+        {
+            const Line *line = this->findLine((int)i);
+            if (line == nullptr)
+                continue;
+            for (size_t j = begin; j < std::min(end, line->getSize()); j++)
+            {
+                const Cell *src = line->getCell(j);
+                if (src == nullptr)
+                    continue;
+                m_Columns[j]->set(i, src->getValue());
+                m_Widths[j]->change(0, src->getLength());
+            }
+        }
+    });
+}
+
+uint64_t Tables::cellKey(const int &row, const int &column)
+{
+    return ((uint64_t)(uint32_t)row << 32) | (uint32_t)column;
+}
+
+std::pair<int, int> Tables::keyCell(const uint64_t &key)
+{
+    return std::pair<int, int>((int)(uint32_t)(key >> 32), (int)(uint32_t)key);
+}
+
+std::vector<std::pair<int, int>> Tables::rangeDependents(const int &row, const int &column) const
+{
+    std::vector<std::pair<int, int>> ret;
+    auto bucket = m_RangeDependents->find(column);
+    if (bucket == m_RangeDependents->end())
+        return ret;
+    for (size_t i = 0; i < bucket->second.size(); i++)
+    {
+        const RangeReference &range = bucket->second[i];
+        if (range.row1 <= row && row <= range.row2)
+            ret.push_back(range.formula);
+    }
+    return ret;
+}
+
+std::vector<std::pair<int, int>> Tables::formulasInRange(const Instruction &ins) const
+{
+    std::vector<std::pair<int, int>> ret;
+    int lastRow = std::min(ins.rowEnd, (int)m_Rows - 1);
+    //Smaller of range and all formulas is searched
+    if ((size_t)(lastRow - ins.row + 1) * (size_t)(ins.columnEnd - ins.column + 1) > m_Formula->size())
+    {
+        for (size_t i = 0; i < m_Formula->size(); i++)
+            if (ins.row <= (*m_Formula)[i].first && (*m_Formula)[i].first <= ins.rowEnd && ins.column <= (*m_Formula)[i].second && (*m_Formula)[i].second <= ins.columnEnd)
+                ret.push_back((*m_Formula)[i]);
+        return ret;
+    }
+    for (int i = ins.row; i <= lastRow; i++)
+    {
+        const Line *line = this->findLine(i);
+        if (line == nullptr)
+            continue;
+        for (int j = ins.column; j <= std::min(ins.columnEnd, (int)line->getSize() - 1); j++)
+        {
+            const Cell *src = line->getCell(j);
+            if (src != nullptr && src->getType() == CellType::FORMULA)
+                ret.push_back(std::pair<int, int>(i, j));
+        }
+    }
+    return ret;
+}
+
+void Tables::linkFormula(const int &row, const int &column)
+{
+    std::pair<int, int> cell(row, column);
+    if (Tables::editShared(m_FormulaIndex).emplace(Tables::cellKey(row, column), m_Formula->size()).second)
+        Tables::editShared(m_Formula).push_back(cell);
+    std::vector<std::pair<int, int>> &references = Tables::editShared(m_References)[Tables::cellKey(row, column)];
+    references.clear();
+    const Formula &formula = (*m_Formulas)[this->findCell(row, column)->getFormula()];
+    for (size_t i = 0; i < formula.code.code.size(); i++)
+    {
+        Instruction ins = formula.instruction(i, row, column);
+        if (isAggregateOp(ins.op))
+        {
+            //Range is one reference, it is not split to Cells
+            RangeReference range = {ins.row, ins.column, ins.rowEnd, ins.columnEnd, cell};
+            for (int j = ins.column; j <= ins.columnEnd; j++)
+            {
+                Tables::editShared(m_RangeDependents)[j].push_back(range);
+                //Column read by a long range gets an index, which is built before formulas are counted
+                if (ins.rowEnd - ins.row + 1 >= INDEX_ROWS)
+                    m_ColumnIndex.emplace(j, nullptr);
+            }
+            continue;
+        }
+        if (ins.op != OpCode::CELL)
+            continue;
+        std::pair<int, int> cord(ins.row, ins.column);
+        if (std::find(references.begin(), references.end(), cord) != references.end())
+            continue;
+        references.push_back(cord);
+        Tables::editShared(m_Dependents)[Tables::cellKey(ins.row, ins.column)].insert(Tables::cellKey(row, column));
+    }
+}
+
+void Tables::unlinkFormula(const int &row, const int &column)
+{
+    std::pair<int, int> cell(row, column);
+    if (m_FormulaIndex->count(Tables::cellKey(row, column)) != 0)
+    {
+        std::unordered_map<uint64_t, size_t> &formulaIndex = Tables::editShared(m_FormulaIndex);
+        std::vector<std::pair<int, int>> &formulaCells = Tables::editShared(m_Formula);
+        auto registered = formulaIndex.find(Tables::cellKey(row, column));
+        //Last formula takes place of a removed one
+        size_t index = registered->second;
+        formulaIndex.erase(registered);
+        if (index != formulaCells.size() - 1)
+        {
+            formulaCells[index] = formulaCells.back();
+            formulaIndex[Tables::cellKey(formulaCells[index].first, formulaCells[index].second)] = index;
+        }
+        formulaCells.pop_back();
+    }
+
+    const Cell *src = this->findCell(row, column);
+    if (src != nullptr && src->getType() == CellType::FORMULA)
+    {
+        const Formula &formula = (*m_Formulas)[src->getFormula()];
+        for (size_t i = 0; i < formula.code.code.size(); i++)
+        {
+            Instruction ins = formula.instruction(i, row, column);
+            if (!isAggregateOp(ins.op))
+                continue;
+            for (int j = ins.column; j <= ins.columnEnd; j++)
+            {
+                if (m_RangeDependents->count(j) == 0)
+                    continue;
+                std::vector<RangeReference> &ranges = Tables::editShared(m_RangeDependents)[j];
+                ranges.erase(std::remove_if(ranges.begin(), ranges.end(), [&cell](const RangeReference &range)
+                                            { return range.formula == cell; }),
+                             ranges.end());
+                if (std::none_of(ranges.begin(), ranges.end(), [](const RangeReference &range)
+                                 { return range.row2 - range.row1 + 1 >= INDEX_ROWS; }))
+                    m_ColumnIndex.erase(j);
+                if (ranges.empty())
+                    Tables::editShared(m_RangeDependents).erase(j);
+            }
+        }
+    }
+
+    if (m_References->count(Tables::cellKey(row, column)) == 0)
+        return;
+    std::unordered_map<uint64_t, std::vector<std::pair<int, int>>> &allReferences = Tables::editShared(m_References);
+    std::unordered_map<uint64_t, std::unordered_set<uint64_t>> &allDependents = Tables::editShared(m_Dependents);
+    auto found = allReferences.find(Tables::cellKey(row, column));
+    for (size_t i = 0; i < found->second.size(); i++)
+    {
+        auto dependents = allDependents.find(Tables::cellKey(found->second[i].first, found->second[i].second));
+        if (dependents == allDependents.end())
+            continue;
+        dependents->second.erase(Tables::cellKey(row, column));
+        if (dependents->second.empty())
+            allDependents.erase(dependents);
+    }
+    allReferences.erase(found);
+}
+
+void Tables::markDirty(const int &row, const int &column)
+{
+    std::vector<std::pair<int, int>> stack;
+    stack.push_back(std::pair<int, int>(row, column));
+    while (!stack.empty())
+    {
+        std::pair<int, int> cell = stack.back();
+        stack.pop_back();
+        std::vector<std::pair<int, int>> ranges = this->rangeDependents(cell.first, cell.second);
+        for (size_t i = 0; i < ranges.size(); i++)
+            if (Tables::editShared(m_Dirty).insert(Tables::cellKey(ranges[i].first, ranges[i].second)).second)
+                stack.push_back(ranges[i]);
+        auto dependents = m_Dependents->find(Tables::cellKey(cell.first, cell.second));
+        if (dependents == m_Dependents->end())
+            continue;
+        for (auto it = dependents->second.begin(); it != dependents->second.end(); ++it)
+        {
+            //Already dirty cell has its dependents marked too
+            if (Tables::editShared(m_Dirty).insert(*it).second)
+                stack.push_back(Tables::keyCell(*it));
+        }
+    }
+}
+
+void Tables::copyValue(const int &row1, const int &column1, const int &row2, const int &column2)
+{
+    const Cell *src = this->findCell(row2, column2);
+    if (src == nullptr)
+        throw std::logic_error("Source cell is empty");
+
+    if (src->getType() == CellType::FORMULA)
+    {
+        std::string text;
+        (*m_Formulas)[src->getFormula()].appendText(text, row2, column2);
+        this->addFormula(row1, column1, text);
+        return;
+    }
+
+    std::stringstream os;
+    src->print(os);
+    this->setValue(row1, column1, os.str());
+}
+
+void Tables::exportTable(std::ofstream &outFile) const
+{
+    const Line empty;
+    std::string buffer;
+    buffer.reserve(EXPORT_BUFFER + maxLineSize * 32);
+    //Buffer is written only when it is full, so file isn't flushed after every row
+    auto flush = [&outFile, &buffer](bool force) {
+        if (!force && buffer.size() < EXPORT_BUFFER)
+            return;
+        outFile.write(buffer.data(), (std::streamsize)buffer.size());
+        buffer.clear();
+    };
+
+    for (size_t i = 0; i < m_Rows; i++)
+    {
+        const Line *line = this->findLine((int)i);
+        (line != nullptr ? line : &empty)->exportLine(buffer, maxLineSize);
+        buffer += '\n';
+        flush(false);
+    }
+    buffer += "Function:\n";
+    for (size_t i = 0; i < m_Rows; i++)
+    {
+        const Line *line = this->findLine((int)i);
+        (line != nullptr ? line : &empty)->exportLineFunc(buffer, *m_Formulas, maxLineSize, i);
+        buffer += '\n';
+        flush(false);
+    }
+    flush(true);
+}
+
+/**
+ * @brief Helping function, which cuts next line from a buffer
+ *
+ * @param data buffer, line will be removed from its beginning
+ * @return std::string_view line without end of line symbols
+ */
+static std::string_view nextLine(std::string_view &data)
+{
+    size_t end = data.find('\n');
+    std::string_view line = data.substr(0, end);
+    data.remove_prefix(end == std::string_view::npos ? data.size() : end + 1);
+    if (!line.empty() && line.back() == '\r')
+        line.remove_suffix(1);
+    return line;
+}
+
+/**
+ * @brief Helping function, which cuts next value from a line and removes quotes around it
+ *
+ * @param line line, value will be removed from its beginning
+ * @return std::string_view value without quotes
+ */
+static std::string_view nextValue(std::string_view &line)
+{
+    size_t end = line.find(',');
+    std::string_view value = line.substr(0, end);
+    line.remove_prefix(end == std::string_view::npos ? line.size() : end + 1);
+    if (!value.empty() && value.front() == '"')
+        value.remove_prefix(1);
+    if (!value.empty() && value.back() == '"')
+        value.remove_suffix(1);
+    return value;
+}
+
+/**
+ * @brief Helping function, which maps a file to memory and passes it to a function
+ *
+ * @param fileName path to a file
+ * @param read function, which reads mapped file
+ */
+static void readMapped(const std::string &fileName, const std::function<void(std::string_view)> &read)
+{
+    int fd = open(fileName.c_str(), O_RDONLY);
+    if (fd < 0)
+        throw std::logic_error("File cannot be open");
+    struct stat info;
+    if (fstat(fd, &info) != 0)
+    {
+        close(fd);
+        throw std::logic_error("File cannot be open");
+    }
+    size_t size = (size_t)info.st_size;
+    if (size == 0)
+    {
+        close(fd);
+        read(std::string_view());
+        return;
+    }
+    void *map = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED)
+        throw std::logic_error("File cannot be open");
+    madvise(map, size, MADV_SEQUENTIAL);
+
+    try
+    {
+        read(std::string_view(static_cast<const char *>(map), size));
+    }
+    catch (...)
+    {
+        munmap(map, size);
+        throw;
+    }
+    munmap(map, size);
+}
+
+void Tables::importTable(const std::string &fileName)
+{
+    readMapped(fileName, [this](std::string_view data) { this->importTable(data); });
+}
+
+void Tables::importTable(std::string_view data)
+{
+    this->deleteAll();
+
+    //First pass splits file to lines, so table is presized once and lines can be parsed by threads
+    std::vector<std::string_view> values;
+    std::vector<std::string_view> functions;
+    int columns = 0;
+    bool formula = false;
+    while (!data.empty())
+    {
+        std::string_view line = nextLine(data);
+        if (line == "Function:")
+        {
+            formula = true;
+            continue;
+        }
+        if (formula)
+        {
+            functions.push_back(line);
+            continue;
+        }
+        values.push_back(line);
+        columns = std::max(columns, (int)std::count(line.begin(), line.end(), ',') + 1);
+    }
+    this->changeSize((int)values.size());
+    this->changeLineSize(columns);
+    m_Table.resize((values.size() + BLOCK_SIZE - 1) / BLOCK_SIZE);
+
+    //Every thread fills its own blocks of Lines, Table is empty, so Cells are written straight to Lines
+    parallelFor(m_Table.size(), IMPORT_BLOCKS, [this, &values](size_t begin, size_t end) {
+        for (size_t block = begin; block < end; block++)
+        {
+            for (size_t row = block * BLOCK_SIZE; row < std::min(values.size(), (block + 1) * BLOCK_SIZE); row++)
+            {
+                std::string_view line = values[row];
+                int ind = 0;
+                while (!line.empty())
+                {
+                    std::string_view value = nextValue(line);
+                    ind++;
+                    if (value.empty())
+                        continue;
+                    this->makeBlock(block)[row % BLOCK_SIZE].setValue(ind - 1, std::string(value));
+                }
+            }
+        }
+    });
+
+    this->buildColumns();
+
+    //Formulas are compiled by threads and then added to a table one by one
+    std::vector<std::pair<int, int>> positions;
+    std::vector<std::string_view> texts;
+    for (size_t row = 0; row < functions.size(); row++)
+    {
+        std::string_view line = functions[row];
+        int ind = 0;
+        while (!line.empty())
+        {
+            std::string_view value = nextValue(line);
+            ind++;
+            if (value.empty())
+                continue;
+            positions.push_back(std::pair<int, int>((int)row, ind - 1));
+            texts.push_back(value);
+        }
+    }
+    std::vector<Formula> compiled(texts.size());
+    parallelFor(texts.size(), IMPORT_FORMULAS, [&compiled, &texts](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++)
+            compiled[i] = Tables::compileFormula(std::string(texts[i]));
+    });
+
+    for (size_t i = 0; i < positions.size(); i++)
+    {
+        int row = positions[i].first;
+        int column = positions[i].second;
+        this->changeLineSize(column + 1);
+        size_t length = this->cellLength(row, column);
+        this->releaseFormula(row, column);
+        int index = this->storeFormula(std::move(compiled[i]), row, column);
+        this->makeLine(row).setFormula(column, index);
+        this->updateIndex(row, column, length);
+        this->linkFormula(row, column);
+        Tables::editShared(m_Dirty).insert(Tables::cellKey(row, column));
+    }
+}
+
+//!> first bytes of a binary snapshot
+static const char SNAPSHOT_MAGIC[4] = {'T', 'B', 'L', 'S'};
+
+/**
+ * @brief Helping function, which writes bytes of a value to a file
+ *
+ * @param of file, where value will be written
+ * @param src value
+ */
+template <typename T>
+static void writeRaw(std::ofstream &of, const T &src)
+{
+    of.write(reinterpret_cast<const char *>(&src), sizeof(T));
+}
+
+/**
+ * @brief Helping function, which writes a line with its length to a file
+ *
+ * @param of file, where line will be written
+ * @param src line
+ */
+static void writeString(std::ofstream &of, const std::string &src)
+{
+    writeRaw(of, (uint64_t)src.size());
+    of.write(src.data(), (std::streamsize)src.size());
+}
+
+/**
+ * @brief Helping function, which writes a Value with its type to a file
+ *
+ * @param of file, where Value will be written
+ * @param src Value
+ */
+static void writeValue(std::ofstream &of, const Value &src)
+{
+    writeRaw(of, (uint8_t)src.getType());
+    if (src.getType() == ValueType::NUMBER)
+        writeRaw(of, src.getNumber());
+    else
+        writeString(of, src.getString());
+}
+
+/**
+ * @brief Helping function, which cuts bytes of a value from a beginning of a snapshot
+ *
+ * @param data snapshot, value will be removed from its beginning
+ * @return T read value
+ */
+template <typename T>
+static T readRaw(std::string_view &data)
+{
+    if (data.size() < sizeof(T))
+        throw std::logic_error("File is not a correct snapshot");
+    T ret;
+    memcpy(&ret, data.data(), sizeof(T));
+    data.remove_prefix(sizeof(T));
+    return ret;
+}
+
+/**
+ * @brief Helping function, which cuts a line with its length from a beginning of a snapshot
+ *
+ * @param data snapshot, line will be removed from its beginning
+ * @return std::string read line
+ */
+static std::string readString(std::string_view &data)
+{
+    uint64_t size = readRaw<uint64_t>(data);
+    if (data.size() < size)
+        throw std::logic_error("File is not a correct snapshot");
+    std::string ret(data.substr(0, size));
+    data.remove_prefix(size);
+    return ret;
+}
+
+/**
+ * @brief Helping function, which cuts a Value with its type from a beginning of a snapshot
+ *
+ * @param data snapshot, Value will be removed from its beginning
+ * @return Value read Value
+ */
+static Value readValue(std::string_view &data)
+{
+    ValueType type = (ValueType)readRaw<uint8_t>(data);
+    switch (type)
+    {
+    case ValueType::NUMBER:
+        return Value(readRaw<double>(data));
+    case ValueType::STRING:
+        return Value(readString(data));
+    case ValueType::ERROR:
+        return Value::error(readString(data));
+    default:
+        throw std::logic_error("File is not a correct snapshot");
+    }
+}
+
+/**
+ * @brief Helping function, which makes a separate formula of a Cell from a shared one
+ *
+ * @param shared formula, which is shared by Cells
+ * @param row row, where Cell is situated
+ * @param column column, where Cell is situated
+ * @return Formula formula with text, references and names of a Cell
+ */
+static Formula placeFormula(const Formula &shared, const int &row, const int &column)
+{
+    if (shared.row == row && shared.column == column)
+        return shared;
+    Formula ret;
+    shared.appendText(ret.text, row, column);
+    ret.code.strings = shared.code.strings;
+    ret.code.maxStack = shared.code.maxStack;
+    for (size_t i = 0; i < shared.code.code.size(); i++)
+    {
+        ret.code.code.push_back(shared.instruction(i, row, column));
+        const Instruction &ins = ret.code.code.back();
+        if (ins.op != OpCode::CELL && !isAggregateOp(ins.op))
+            continue;
+        std::string &name = ret.code.strings[ins.text];
+        if (name.find(':') == std::string::npos)
+            name = cellName(ins.row, ins.column);
+        else
+            name = cellName(ins.row, ins.column) + ":" + cellName(ins.rowEnd, ins.columnEnd);
+    }
+    return ret;
+}
+
+void Tables::exportBinary(std::ofstream &outFile) const
+{
+    uint64_t cells = 0;
+    for (size_t i = 0; i < m_Rows; i++)
+    {
+        const Line *line = this->findLine((int)i);
+        if (line == nullptr)
+            continue;
+        for (size_t j = 0; j < line->getSize(); j++)
+            if (line->getCell(j) != nullptr)
+                cells++;
+    }
+
+    outFile.write(SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+    writeRaw(outFile, SNAPSHOT_VERSION);
+    writeRaw(outFile, (uint64_t)m_Rows);
+    writeRaw(outFile, (uint64_t)maxLineSize);
+    writeRaw(outFile, cells);
+
+    for (size_t i = 0; i < m_Rows; i++)
+    {
+        const Line *line = this->findLine((int)i);
+        if (line == nullptr)
+            continue;
+        for (size_t j = 0; j < line->getSize(); j++)
+        {
+            const Cell *src = line->getCell(j);
+            if (src == nullptr)
+                continue;
+            writeRaw(outFile, (int32_t)i);
+            writeRaw(outFile, (int32_t)j);
+            writeRaw(outFile, (uint8_t)src->getType());
+            writeValue(outFile, src->getValue());
+            if (src->getType() != CellType::FORMULA)
+                continue;
+
+            //Formula is saved already compiled, so it doesn't need to be parsed again
+            Formula formula = placeFormula((*m_Formulas)[src->getFormula()], (int)i, (int)j);
+            writeString(outFile, formula.text);
+            writeRaw(outFile, (uint64_t)formula.code.code.size());
+            for (size_t k = 0; k < formula.code.code.size(); k++)
+            {
+                const Instruction &instruction = formula.code.code[k];
+                writeRaw(outFile, (uint8_t)instruction.op);
+                writeRaw(outFile, (int32_t)instruction.row);
+                writeRaw(outFile, (int32_t)instruction.column);
+                writeRaw(outFile, (int32_t)instruction.rowEnd);
+                writeRaw(outFile, (int32_t)instruction.columnEnd);
+                writeRaw(outFile, (int32_t)instruction.text);
+                writeRaw(outFile, instruction.number);
+            }
+            writeRaw(outFile, (uint64_t)formula.code.strings.size());
+            for (size_t k = 0; k < formula.code.strings.size(); k++)
+                writeString(outFile, formula.code.strings[k]);
+            writeRaw(outFile, (uint64_t)formula.code.maxStack);
+        }
+    }
+
+    //Dirty formulas are saved in order of rows, so the same table gives the same snapshot
+    std::vector<uint64_t> dirty(m_Dirty->begin(), m_Dirty->end());
+    std::sort(dirty.begin(), dirty.end());
+    writeRaw(outFile, (uint64_t)dirty.size());
+    for (size_t i = 0; i < dirty.size(); i++)
+    {
+        std::pair<int, int> cell = Tables::keyCell(dirty[i]);
+        writeRaw(outFile, (int32_t)cell.first);
+        writeRaw(outFile, (int32_t)cell.second);
+    }
+}
+
+/**
+ * @brief Helping function, which checks instructions of a formula read from a snapshot and counts the max depth of its stack the same way as a compiler does
+ *
+ * @param code instructions of a formula
+ * @return size_t max number of values on a stack while executing
+ */
+static size_t countStack(const Bytecode &code)
+{
+    size_t depth = 0;
+    size_t ret = 0;
+    for (size_t i = 0; i < code.code.size(); i++)
+    {
+        const Instruction &ins = code.code[i];
+        //Range exists only while compiling
+        if (ins.op > OpCode::COUNT || ins.op == OpCode::RANGE)
+            throw std::logic_error("File is not a correct snapshot");
+        bool reference = ins.op == OpCode::CELL || isAggregateOp(ins.op);
+        if ((reference || ins.op == OpCode::STRING) && (ins.text < 0 || (size_t)ins.text >= code.strings.size()))
+            throw std::logic_error("File is not a correct snapshot");
+        if (reference && (ins.row < 0 || ins.column < 0 || ins.rowEnd < ins.row || ins.columnEnd < ins.column))
+            throw std::logic_error("File is not a correct snapshot");
+
+        if (ins.op == OpCode::SIN || ins.op == OpCode::COS || ins.op == OpCode::SQRT)
+            depth = std::max(depth, (size_t)1);
+        else if (ins.op >= OpCode::ADD && ins.op <= OpCode::DIV)
+        {
+            if (depth > 1)
+                depth--;
+        }
+        else
+            depth++;
+        ret = std::max(ret, depth);
+    }
+    return ret;
+}
+
+void Tables::importBinary(const std::string &fileName)
+{
+    readMapped(fileName, [this](std::string_view data) { this->importBinary(data); });
+}
+
+void Tables::importBinary(std::string_view data)
+{
+    //Snapshot is read into a new table, so a wrong snapshot doesn't change this one
+    Tables loaded;
+    loaded.loadBinary(data);
+    loaded.m_Deferred = m_Deferred;
+    loaded.m_Backup = m_Backup;
+    *this = std::move(loaded);
+}
+
+void Tables::loadBinary(std::string_view data)
+{
+    if (data.size() < sizeof(SNAPSHOT_MAGIC) || memcmp(data.data(), SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0)
+        throw std::logic_error("File is not a correct snapshot");
+    data.remove_prefix(sizeof(SNAPSHOT_MAGIC));
+    if (readRaw<uint32_t>(data) != SNAPSHOT_VERSION)
+        throw std::logic_error("Snapshot has unsupported version");
+
+    uint64_t rows = readRaw<uint64_t>(data);
+    uint64_t columns = readRaw<uint64_t>(data);
+    uint64_t cells = readRaw<uint64_t>(data);
+    if (rows > (uint64_t)std::numeric_limits<int>::max() || columns > (uint64_t)std::numeric_limits<int>::max())
+        throw std::logic_error("File is not a correct snapshot");
+    this->changeSize((int)rows);
+    this->changeLineSize((int)columns);
+    m_Table.reserve((size_t)((rows + BLOCK_SIZE - 1) / BLOCK_SIZE));
+
+    //Formulas are linked after all Cells are read
+    std::vector<std::pair<int, int>> formulas;
+    for (uint64_t i = 0; i < cells; i++)
     {
-        if (newCell->whatIs() == "CellFunc")
+        int row = readRaw<int32_t>(data);
+        int column = readRaw<int32_t>(data);
+        if (row < 0 || column < 0 || (uint64_t)row >= rows || (uint64_t)column >= columns)
+            throw std::logic_error("File is not a correct snapshot");
+        CellType type = (CellType)readRaw<uint8_t>(data);
+        Value inside = readValue(data);
+
+        Cell newCell;
+        if (type == CellType::NUMBER && inside.getType() == ValueType::NUMBER)
+            newCell.setNumber(inside.getNumber());
+        else if (type == CellType::STRING && inside.getType() == ValueType::STRING)
+            newCell.setString(inside.getString());
+        else if (type == CellType::FORMULA)
         {
-            for (size_t i = 0; i < m_Formula.size(); i++)
+            Formula formula;
+            formula.text = readString(data);
+            uint64_t size = readRaw<uint64_t>(data);
+            if (size > data.size())
+                throw std::logic_error("File is not a correct snapshot");
+            formula.code.code.resize((size_t)size);
+            for (size_t k = 0; k < formula.code.code.size(); k++)
             {
-                if (m_Formula[i].first == row && m_Formula[i].second == column)
-                {
-                    m_Formula.erase(m_Formula.begin() + i);
-                    break;
-                }
+                Instruction &instruction = formula.code.code[k];
+                instruction.op = (OpCode)readRaw<uint8_t>(data);
+                instruction.row = readRaw<int32_t>(data);
+                instruction.column = readRaw<int32_t>(data);
+                instruction.rowEnd = readRaw<int32_t>(data);
+                instruction.columnEnd = readRaw<int32_t>(data);
+                instruction.text = readRaw<int32_t>(data);
+                instruction.number = readRaw<double>(data);
             }
+            size = readRaw<uint64_t>(data);
+            if (size > data.size())
+                throw std::logic_error("File is not a correct snapshot");
+            formula.code.strings.resize((size_t)size);
+            for (size_t k = 0; k < formula.code.strings.size(); k++)
+                formula.code.strings[k] = readString(data);
+            //Saved depth of a stack is not trusted, it is counted again from instructions
+            readRaw<uint64_t>(data);
+            formula.code.maxStack = countStack(formula.code);
+
+            newCell.setFormula(this->storeFormula(std::move(formula), row, column));
+            newCell.setInside(inside);
+            formulas.push_back(std::pair<int, int>(row, column));
         }
+        else
+            throw std::logic_error("File is not a correct snapshot");
+        this->makeLine(row).setCell(column, newCell);
     }
-    m_Table[row].setValue(column, input);
-}
-
-void Tables::copyValue(const int &row1, const int &column1, const int &row2, const int &column2)
-{
-    if (row2 >= (int)m_Table.size() || column2 >= (int)maxLineSize)
-        throw std::logic_error("Source cell is empty");
-    Cell *src = m_Table[row2].getCell(column2);
-    if (src == nullptr)
-        throw std::logic_error("Source cell is empty");
 
-    this->changeSize(row1 + 1);
-    this->changeLineSize(column1 + 1);
+    this->buildColumns();
+    for (size_t i = 0; i < formulas.size(); i++)
+        this->linkFormula(formulas[i].first, formulas[i].second);
 
-    if (src->whatIs() == "CellFunc")
+    uint64_t dirty = readRaw<uint64_t>(data);
+    for (uint64_t i = 0; i < dirty; i++)
     {
-        std::stringstream s;
-        src->printFunc(s);
-        this->addFormula(row1, column1, s.str());
-        return;
+        int row = readRaw<int32_t>(data);
+        int column = readRaw<int32_t>(data);
+        const Cell *src = this->findCell(row, column);
+        if (src == nullptr || src->getType() != CellType::FORMULA)
+            throw std::logic_error("File is not a correct snapshot");
+        Tables::editShared(m_Dirty).insert(Tables::cellKey(row, column));
     }
-
-    std::stringstream os;
-    src->print(os);
-    this->setValue(row1, column1, os.str());
 }
 
-void Tables::printInd(const size_t &lineLenth, const std::vector<size_t> &CellWidth, int startWith)
+/**
+ * @brief Helping function, which writes whole buffer to a console by one call
+ *
+ * @param buffer printed frame
+ */
+static void writeFrame(const std::string &buffer)
 {
-    for (size_t i = startWith; i < lineLenth; i++)
+    //Everything written by std::cout before is written first
+    std::cout.flush();
+    size_t written = 0;
+    while (written < buffer.size())
     {
-        std::deque<int> pow27(0);
-        int num = (int)i;
-        for (int j = 0; num > 0; j++)
-        {
-            pow27.push_back(num % 26);
-            num = num / 26;
-        }
-        if (pow27.empty())
-            pow27.push_back(0);
-
-        std::cout << "|" << std::setw((int)CellWidth[i]);
-        std::string output;
-        for (size_t j = 0; j < pow27.size(); j++)
-        {
-            output.insert(output.begin(), (char)(pow27[j] - (int)j + 65));
-        }
-        std::cout << output;
+        ssize_t res = ::write(STDOUT_FILENO, buffer.data() + written, buffer.size() - written);
+        if (res < 0 && errno == EINTR)
+            continue;
+        if (res <= 0)
+            break;
+        written += (size_t)res;
     }
-    std::cout << "|" << std::endl;
 }
 
-void Tables::exportTable(std::ofstream &outFile) const
+size_t Tables::columnWidth(const size_t &column) const
 {
-    for (size_t i = 0; i < m_Table.size(); i++)
+    if (column >= m_Widths.size() || m_Widths[column] == nullptr)
+        return 0;
+    return m_Widths[column]->getWidth();
+}
+
+void Tables::appendFrame(std::string &buffer, const std::vector<size_t> &CellWidth, const size_t &maxInd, const size_t &row1, const size_t &row2, const size_t &column1, const size_t &column2) const
+{
+    size_t fullSize = 1;
+    for (size_t j = column1; j <= column2; j++)
+        fullSize += CellWidth[j] + 1;
+    size_t lineSize = fullSize + maxInd + 3;
+    //Every row has a line with Cells and a line with '-', header has three lines
+    buffer.reserve(buffer.size() + (lineSize + 1) * (2 * (row2 - row1 + 1) + 3));
+
+    buffer.append(lineSize, '-');
+    buffer += '\n';
+    buffer += '|';
+    buffer.append(maxInd - 2, ' ');
+    buffer += "IND|";
+    for (size_t j = column1; j <= column2; j++)
     {
-        m_Table[i].exportLine(outFile);
-        outFile << std::endl;
+        std::string name = cellName(0, (int)j);
+        name.pop_back();
+        std::transform(name.begin(), name.end(), name.begin(), ::toupper);
+        buffer += '|';
+        buffer.append(CellWidth[j] > name.size() ? CellWidth[j] - name.size() : 0, ' ');
+        buffer += name;
     }
-    outFile << "Function:" << std::endl;
-    for (size_t i = 0; i < m_Table.size(); i++)
+    buffer += "|\n";
+    buffer.append(lineSize, '=');
+    buffer += '\n';
+
+    const Line empty;
+    char ind[32];
+    for (size_t i = row1; i <= row2; i++)
     {
-        m_Table[i].exportLineFunc(outFile);
-        outFile << std::endl;
+        size_t length = (size_t)(std::to_chars(ind, ind + sizeof(ind), i + 1).ptr - ind);
+        buffer += '|';
+        buffer.append(maxInd + 1 > length ? maxInd + 1 - length : 0, ' ');
+        buffer.append(ind, length);
+        buffer += '|';
+        const Line *line = this->findLine((int)i);
+        (line != nullptr ? line : &empty)->appendRange(buffer, CellWidth, column1, column2);
+        buffer.append(lineSize, '-');
+        buffer += '\n';
     }
 }
 
-void Tables::importTable(std::ifstream &inFile)
+void Tables::appendFormulas(std::string &buffer, const size_t &row1, const size_t &row2, const size_t &column1, const size_t &column2) const
 {
-    this->deleteAll();
-    std::string line;
-    bool formula = false;
-    int row = 0;
-    while (std::getline(inFile, line))
+    buffer += "FUNCTIONS:\n";
+    for (size_t i = row1; i <= row2; i++)
     {
-        std::stringstream sstream;
-        sstream.str(line);
-        std::string value;
-        if (line == "Function:")
-        {
-            formula = true;
-            row = 0;
-            continue;
-        }
-        if (!formula)
-            m_Table.push_back(Line());
-        int ind = 0;
-        row++;
-        while (std::getline(sstream, value, ','))
-        {
-            ind++;
-            if (!formula)
-            {
-                value.erase(value.begin());
-                value.erase(value.end() - 1);
-                m_Table[m_Table.size() - 1].changeSize(ind);
-                if (!value.empty())
-                {
-                    this->setValue((int)m_Table.size() - 1, ind - 1, value);
-                }
-            }
-            else
-            {
-                value.erase(value.begin());
-                value.erase(value.end() - 1);
-                if (!value.empty())
-                {
-                    m_Table[row - 1].setFormula(ind - 1, value);
-                    m_Formula.push_back(std::pair<int, int>(row - 1, ind - 1));
-                }
-            }
-        }
+        const Line *line = this->findLine((int)i);
+        if (line != nullptr && line->hasFormula())
+            line->appendFormula(buffer, i, *m_Formulas, column1, column2);
     }
 }
 
-void Tables::printLine(const size_t &fullSize, const size_t &maxInd)
-{
-    for (size_t j = 0; j < fullSize + maxInd + 3; j++)
-        std::cout << '-';
-    std::cout << std::endl;
-}
-
 void Tables::printTable(bool function) const
 {
     if (maxLineSize == 0)
@@ -201,27 +1109,19 @@ void Tables::printTable(bool function) const
     }
 
     //Get size of a current opened terminal
-    struct winsize w;
+    struct winsize w = {};
     ioctl(STDOUT_FILENO, TIOCGWINSZ, &w);
 
+    const Line empty;
     std::vector<size_t> CellWidth(maxLineSize);
-    for (size_t i = 0; i < m_Table.size(); i++)
+    size_t fullSize = 1;
+    for (size_t j = 0; j < maxLineSize; j++)
     {
-        for (size_t j = 0; j < maxLineSize; j++)
-        {
-            if (CellWidth[j] < m_Table[i].getCellWidth(j))
-                CellWidth[j] = m_Table[i].getCellWidth(j);
-        }
+        CellWidth[j] = std::max(this->columnWidth(j), empty.getCellWidth(j));
+        fullSize += CellWidth[j] + 1;
     }
 
-    size_t fullSize = 1;
-    for (size_t i = 0; i < maxLineSize; i++)
-        fullSize += CellWidth[i] + 1;
-
-    size_t maxInd = (int)m_Table.size();
-    maxInd = std::to_string(maxInd).length();
-    if (maxInd < 3)
-        maxInd = 3;
+    size_t maxInd = std::max(std::to_string(m_Rows).length(), (size_t)3);
 
     size_t size = w.ws_col;
     if (size <= fullSize + maxInd + 3)
@@ -230,86 +1130,108 @@ void Tables::printTable(bool function) const
         return;
     }
 
-    std::cout << "|-> YOUR TABLE:" << std::endl;
-    Tables::printLine(fullSize, maxInd);
-    std::cout << "|" << std::setw((int)maxInd + 1) << "IND" << "|";
-    Tables::printInd(maxLineSize, CellWidth);
+    std::string buffer = "|-> YOUR TABLE:\n";
+    this->appendFrame(buffer, CellWidth, maxInd, 0, m_Rows - 1, 0, maxLineSize - 1);
+    if (function)
+        this->appendFormulas(buffer, 0, m_Rows - 1, 0, 0);
+    writeFrame(buffer);
+}
 
-    for (size_t j = 0; j < fullSize + maxInd + 3; j++)
-        std::cout << '=';
-    std::cout << std::endl;
+void Tables::printPage(const size_t &rowPage, const size_t &columnPage) const
+{
+    if (maxLineSize == 0)
+    {
+        std::cout << "|-> EMPTY TABLE" << std::endl;
+        return;
+    }
 
-    for (size_t i = 0; i < m_Table.size(); i++)
+    //Size of a console is not known, when output is not a terminal
+    struct winsize w;
+    size_t width = PAGE_WIDTH;
+    size_t height = PAGE_HEIGHT;
+    if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &w) == 0 && w.ws_col > 0 && w.ws_row > 0)
     {
-        std::cout << "|" << std::setw((int)maxInd + 1) << i + 1 << "|";
-        m_Table[i].print(std::cout, CellWidth);
-        Tables::printLine(fullSize, maxInd);
+        width = w.ws_col;
+        height = w.ws_row;
     }
 
-    if (function)
+    size_t maxInd = std::max(std::to_string(m_Rows).length(), (size_t)3);
+    //Every row takes two lines, title, header and input take six lines
+    size_t pageRows = height > 8 ? (height - 6) / 2 : 1;
+    size_t rowPages = (m_Rows + pageRows - 1) / pageRows;
+
+    //Columns are split to pages with widths of whole columns, so columns don't change their width between pages
+    const Line empty;
+    std::vector<size_t> CellWidth(maxLineSize);
+    std::vector<size_t> pageStart(1, 0);
+    size_t fullSize = 1;
+    for (size_t j = 0; j < maxLineSize; j++)
     {
-        std::cout << "FUNCTIONS:" << std::endl;
-        for (size_t i = 0; i < m_Table.size(); i++)
+        CellWidth[j] = std::max(this->columnWidth(j), empty.getCellWidth(j));
+        if (j != pageStart.back() && fullSize + CellWidth[j] + 1 + maxInd + 3 > width)
         {
-            if (m_Table[i].hasFormula())
-            {
-                m_Table[i].printFormula(i);
-            }
+            pageStart.push_back(j);
+            fullSize = 1;
         }
+        fullSize += CellWidth[j] + 1;
     }
+    pageStart.push_back(maxLineSize);
+
+    if (rowPage == 0 || rowPage > rowPages || columnPage == 0 || columnPage >= pageStart.size())
+        throw std::logic_error("Page doesn't exist");
+
+    size_t row1 = (rowPage - 1) * pageRows;
+    size_t row2 = std::min(row1 + pageRows, m_Rows) - 1;
+    std::string buffer = "|-> YOUR TABLE, ROWS " + std::to_string(rowPage) + "/" + std::to_string(rowPages) + ", COLUMNS " + std::to_string(columnPage) + "/" + std::to_string(pageStart.size() - 1) + ":\n";
+    this->appendFrame(buffer, CellWidth, maxInd, row1, row2, pageStart[columnPage - 1], pageStart[columnPage] - 1);
+    writeFrame(buffer);
 }
 
 bool Tables::isEmpty() const
 {
-    if (m_Table.empty())
+    if (m_Rows == 0)
         return true;
     return false;
 }
 
 void Tables::printCell(const int &row1, const int &column1, bool function) const
 {
-    if (row1 >= (int)m_Table.size() || column1 >= (int)maxLineSize)
-        throw std::out_of_range("Cell is empty");
-
-    Cell *src = m_Table[row1].getCell(column1);
+    const Cell *src = this->findCell(row1, column1);
     if (src == nullptr)
         throw std::out_of_range("Cell is empty");
 
     std::cout << "|-> DATA = ";
     src->print(std::cout);
-    if (src->whatIs() == "CellFunc" && function)
+    if (src->getType() == CellType::FORMULA && function)
     {
+        std::string text;
+        (*m_Formulas)[src->getFormula()].appendText(text, row1, column1);
         std::cout << " || FORMULA = ";
-        src->printFunc(std::cout);
+        std::cout << text;
     }
     std::cout << std::endl;
 }
 
 void Tables::printRange(const int &row1, const int &column1, const int &row2, const int &column2, bool function) const
 {
-    if (row2 >= (int)m_Table.size() || column2 >= (int)maxLineSize || row1 >= (int)m_Table.size() || column1 >= (int)maxLineSize)
+    if (row2 >= (int)m_Rows || column2 >= (int)maxLineSize || row1 >= (int)m_Rows || column1 >= (int)maxLineSize)
         throw std::logic_error("Range is bigger than table itself");
 
     if (row2 < row1 || column2 < column1)
         throw std::logic_error("Starting cell's index is smaller than a ending's cell index");
 
-    struct winsize w;
+    struct winsize w = {};
     ioctl(STDOUT_FILENO, TIOCGWINSZ, &w);
 
+    const Line empty;
     std::vector<size_t> CellWidth(maxLineSize);
-    for (int i = row1; i <= row2; i++)
+    size_t fullSize = 1;
+    for (int j = column1; j <= column2; j++)
     {
-        for (int j = column1; j <= column2; j++)
-        {
-            if (CellWidth[j] < m_Table[i].getCellWidth(j))
-                CellWidth[j] = m_Table[i].getCellWidth(j) + 1;
-        }
+        CellWidth[j] = std::max(this->columnWidth((size_t)j), empty.getCellWidth((size_t)j)) + 1;
+        fullSize += CellWidth[j] + 1;
     }
 
-    size_t fullSize = 1;
-    for (int i = column1; i <= column2; i++)
-        fullSize += CellWidth[i] + 1;
-
     size_t size = w.ws_col;
     if (size < fullSize)
     {
@@ -317,110 +1239,105 @@ void Tables::printRange(const int &row1, const int &column1, const int &row2, co
         return;
     }
 
-    size_t maxInd = std::to_string(row2).length();
-    if (maxInd < 3)
-        maxInd = 3;
-
-    std::cout << "|-> YOUR TABLE:" << std::endl;
-    Tables::printLine(fullSize, maxInd);
-    std::cout << "|" << std::setw((int)maxInd + 1) << "IND"
-              << "|";
-    Tables::printInd(column2 + 1, CellWidth, (size_t)column1);
-
-    for (size_t j = 0; j < fullSize + maxInd + 3; j++)
-        std::cout << '=';
-    std::cout << std::endl;
-
-    for (int i = row1; i <= row2; i++)
-    {
-        std::cout << "|" << std::setw((int)maxInd + 1) << i + 1 << "|";
-        m_Table[i].printRange(std::cout, CellWidth, column1, column2);
-        Tables::printLine(fullSize, maxInd);
-    }
+    size_t maxInd = std::max(std::to_string(row2).length(), (size_t)3);
 
+    std::string buffer = "|-> YOUR TABLE:\n";
+    this->appendFrame(buffer, CellWidth, maxInd, (size_t)row1, (size_t)row2, (size_t)column1, (size_t)column2);
     if (function)
-    {
-        std::cout << "FUNCTIONS:" << std::endl;
-        for (int i = row1; i <= row2; i++)
-        {
-            if (m_Table[i].hasFormula())
-            {
-                m_Table[i].printFormula(i, column1, column2);
-            }
-        }
-    }
+        this->appendFormulas(buffer, (size_t)row1, (size_t)row2, (size_t)column1, (size_t)column2);
+    writeFrame(buffer);
 }
 
 void Tables::deleteAll()
 {
+    //Cells are freed with whole slabs, if no copy of a table shares them
     this->m_Table.clear();
-    this->m_Formula.clear();
+    if (m_Pool.use_count() == 1)
+        this->m_Pool->clear();
+    else
+        this->m_Pool = std::make_shared<CellPool>();
+    this->m_Rows = 0;
+    this->m_Formula = std::make_shared<std::vector<std::pair<int, int>>>();
+    this->m_FormulaIndex = std::make_shared<std::unordered_map<uint64_t, size_t>>();
+    this->m_References = std::make_shared<std::unordered_map<uint64_t, std::vector<std::pair<int, int>>>>();
+    this->m_Dependents = std::make_shared<std::unordered_map<uint64_t, std::unordered_set<uint64_t>>>();
+    this->m_RangeDependents = std::make_shared<std::unordered_map<int, std::vector<RangeReference>>>();
+    this->m_ColumnIndex.clear();
+    this->m_Columns.clear();
+    this->m_Widths.clear();
+    this->m_Dirty = std::make_shared<std::unordered_set<uint64_t>>();
+    this->m_Formulas = std::make_shared<std::vector<Formula>>();
+    this->m_FreeFormulas = std::make_shared<std::vector<int>>();
     this->maxLineSize = 0;
 }
 
 void Tables::deleteEmpty()
 {
-    for (int i = (int)m_Table.size() - 1; i >= 0; i--)
+    while (m_Rows > 0)
     {
-        if (m_Table[i].isEmpty())
-            m_Table.erase(m_Table.begin() + i);
-        else
+        const Line *line = this->findLine((int)m_Rows - 1);
+        if (line != nullptr && !line->isEmpty())
             break;
+        m_Rows--;
     }
-
-    for (size_t i = 0; i < m_Table.size(); i++)
-        m_Table[i].delEmpty();
+    //Blocks after last not empty Line are not needed
+    m_Table.resize(std::min(m_Table.size(), (m_Rows + BLOCK_SIZE - 1) / BLOCK_SIZE));
 
     maxLineSize = 0;
     for (size_t i = 0; i < m_Table.size(); i++)
-        if (maxLineSize < m_Table[i].getSize())
-            maxLineSize = m_Table[i].getSize();
-
-    this->changeLineSize((int)maxLineSize);
+        for (size_t j = 0; m_Table[i] != nullptr && j < m_Table[i]->size(); j++)
+            if (maxLineSize < (*m_Table[i])[j].getSize())
+                maxLineSize = (*m_Table[i])[j].getSize();
 }
 
 void Tables::deleteDepended(const int &row1, const int &column1)
 {
-    std::stringstream s;
-    translateRow(s, row1 + 1, column1);
-    std::string cell = s.str();
-    std::transform(cell.begin(), cell.end(), cell.begin(), ::tolower);
-    for (size_t i = 0; i < m_Table.size(); i++)
+    //Formulas are deleted through a stack, so long chains of formulas don't overflow a call stack
+    std::vector<std::pair<int, int>> deleted(1, std::pair<int, int>(row1, column1));
+    std::vector<std::pair<int, int>> stack;
+    auto found = m_Dependents->find(Tables::cellKey(row1, column1));
+    if (found != m_Dependents->end())
+        for (auto it = found->second.begin(); it != found->second.end(); ++it)
+            stack.push_back(Tables::keyCell(*it));
+    while (!stack.empty())
     {
-        std::vector<int> depend = m_Table[i].deleteDepend(cell);
-        for (size_t j = 0; j < depend.size(); j++)
-        {
-            Cell *delCell = m_Table[i].getCell(depend[j]);
-            if (delCell == nullptr)
-                continue;
-            this->deleteCell((int)i, depend[j]);
-        }
+        std::pair<int, int> cell = stack.back();
+        stack.pop_back();
+        if (this->findCell(cell.first, cell.second) == nullptr)
+            continue;
+        size_t length = this->cellLength(cell.first, cell.second);
+        this->releaseFormula(cell.first, cell.second);
+        this->editLine(cell.first)->delCell(cell.second);
+        this->updateIndex(cell.first, cell.second, length);
+        deleted.push_back(cell);
+        found = m_Dependents->find(Tables::cellKey(cell.first, cell.second));
+        if (found != m_Dependents->end())
+            for (auto it = found->second.begin(); it != found->second.end(); ++it)
+                stack.push_back(Tables::keyCell(*it));
     }
+
+    //Formulas, which read deleted Cells through a range, are only counted again
+    for (size_t i = 0; i < deleted.size(); i++)
+        this->markDirty(deleted[i].first, deleted[i].second);
 }
 
 void Tables::deleteCell(const int &row1, const int &column1)
 {
-    if (row1 >= (int)m_Table.size() || column1 >= (int)maxLineSize)
-        throw std::out_of_range("Cell is empty");
-
-    Cell *src = m_Table[row1].getCell(column1);
+    const Cell *src = this->findCell(row1, column1);
     if (src == nullptr)
         throw std::out_of_range("Cell is empty");
 
-    m_Table[row1].delCell(column1);
+    size_t length = src->getLength();
+    this->releaseFormula(row1, column1);
+    this->editLine(row1)->delCell(column1);
+    this->updateIndex(row1, column1, length);
     this->deleteDepended(row1, column1);
-    for (size_t i = 0; i < m_Formula.size(); i++)
-        if (m_Formula[i].first == row1 && m_Formula[i].second == column1)
-        {
-            m_Formula.erase(m_Formula.begin() + i);
-            break;
-        }
     this->deleteEmpty();
 }
 
 void Tables::deleteRange(const int &row1, const int &column1, const int &row2, const int &column2)
 {
-    if (row2 >= (int)m_Table.size() || column2 >= (int)maxLineSize || row1 >= (int)m_Table.size() || column1 >= (int)maxLineSize)
+    if (row2 >= (int)m_Rows || column2 >= (int)maxLineSize || row1 >= (int)m_Rows || column1 >= (int)maxLineSize)
         throw std::logic_error("Range is bigger than table itself");
 
     if (row2 < row1 || column2 < column1)
@@ -429,261 +1346,514 @@ void Tables::deleteRange(const int &row1, const int &column1, const int &row2, c
     for (int i = row1; i <= row2; i++)
     {
         for (int j = column1; j <= column2; j++)
-            m_Table[i].delCell(j);
+        {
+            if (this->findCell(i, j) == nullptr)
+                continue;
+            size_t length = this->cellLength(i, j);
+            this->releaseFormula(i, j);
+            this->editLine(i)->delCell(j);
+            this->updateIndex(i, j, length);
+            this->markDirty(i, j);
+        }
     }
     this->deleteEmpty();
 }
 
-bool Tables::checkCycle()
+bool Tables::checkCycle(const int &row, const int &column)
 {
-    std::vector<std::pair<int, std::string>> indFunc;
-    for (size_t i = 0; i < m_Formula.size(); i++)
-    {
-        std::stringstream s;
-        translateRow(s, m_Formula[i].first + 1, m_Formula[i].second);
-        std::string tran = s.str();
-        std::transform(tran.begin(), tran.end(), tran.begin(), ::tolower);
-        indFunc.push_back(std::pair<int, std::string>(i, tran));
-    }
+    //Cycle exists only if a Cell read by new formula reads new formula itself, so formulas after new formula are searched
+    std::pair<int, int> cell(row, column);
+    const Cell *src = this->findCell(row, column);
+    if (src == nullptr || src->getType() != CellType::FORMULA)
+        return false;
+    std::unordered_set<uint64_t> read;
+    auto references = m_References->find(Tables::cellKey(row, column));
+    if (references != m_References->end())
+        for (size_t i = 0; i < references->second.size(); i++)
+            read.insert(Tables::cellKey(references->second[i].first, references->second[i].second));
+    std::vector<Instruction> ranges;
+    const Formula &formula = (*m_Formulas)[src->getFormula()];
+    for (size_t i = 0; i < formula.code.code.size(); i++)
+        if (isAggregateOp(formula.code.code[i].op))
+            ranges.push_back(formula.instruction(i, row, column));
 
-    Graph g((int)m_Formula.size());
-    for (size_t i = 0; i < indFunc.size(); i++)
+    std::unordered_set<uint64_t> visited;
+    std::vector<std::pair<int, int>> stack(1, cell);
+    while (!stack.empty())
     {
-        std::vector<std::string> formula = m_Table[m_Formula[i].first].getCell(m_Formula[i].second)->getFormula();
-        for (size_t j = 0; j < formula.size(); j++)
-            if (detectIfIsCell(formula[j]))
-            {
-                for (size_t k = 0; k < indFunc.size(); k++)
-                {
-                    if (indFunc[k].second == formula[j])
-                        g.addEdge((int)i, (int)k);
-                }
-            }
+        std::pair<int, int> current = stack.back();
+        stack.pop_back();
+        std::vector<std::pair<int, int>> next = this->rangeDependents(current.first, current.second);
+        auto dependents = m_Dependents->find(Tables::cellKey(current.first, current.second));
+        if (dependents != m_Dependents->end())
+            for (auto it = dependents->second.begin(); it != dependents->second.end(); ++it)
+                next.push_back(Tables::keyCell(*it));
+
+        for (size_t i = 0; i < next.size(); i++)
+        {
+            if (next[i] == cell || read.count(Tables::cellKey(next[i].first, next[i].second)) != 0)
+                return true;
+            for (size_t j = 0; j < ranges.size(); j++)
+                if (ranges[j].row <= next[i].first && next[i].first <= ranges[j].rowEnd && ranges[j].column <= next[i].second && next[i].second <= ranges[j].columnEnd)
+                    return true;
+            if (visited.insert(Tables::cellKey(next[i].first, next[i].second)).second)
+                stack.push_back(next[i]);
+        }
     }
-    return g.isCyclic();
+    return false;
 }
 
-std::vector<int> Tables::topoSort()
+std::vector<std::vector<std::pair<int, int>>> Tables::topoLevels()
 {
-    std::vector<std::pair<int, std::string>> indFunc;
-    for (size_t i = 0; i < m_Formula.size(); i++)
+    //Formulas are sorted by rows, so they are counted in the same order on every run
+    std::vector<uint64_t> keys(m_Dirty->begin(), m_Dirty->end());
+    std::sort(keys.begin(), keys.end());
+    std::vector<std::pair<int, int>> indFunc(keys.size());
+    std::unordered_map<uint64_t, int> indexes(keys.size());
+    for (size_t i = 0; i < keys.size(); i++)
     {
-        std::stringstream s;
-        translateRow(s, m_Formula[i].first + 1, m_Formula[i].second);
-        std::string tran = s.str();
-        std::transform(tran.begin(), tran.end(), tran.begin(), ::tolower);
-        indFunc.push_back(std::pair<int, std::string>(i, tran));
+        indFunc[i] = Tables::keyCell(keys[i]);
+        indexes[keys[i]] = (int)i;
     }
 
-    Graph g((int)m_Formula.size());
+    //Only dirty formulas are in a graph, other formulas already have counted value
+    Graph g((int)indFunc.size());
     for (size_t i = 0; i < indFunc.size(); i++)
     {
-        std::vector<std::string> formula = m_Table[m_Formula[i].first].getCell(m_Formula[i].second)->getFormula();
-        for (size_t j = 0; j < formula.size(); j++)
-            if (detectIfIsCell(formula[j]))
-            {
-                for (size_t k = 0; k < indFunc.size(); k++)
-                {
-                    if (indFunc[k].second == formula[j])
-                        g.addEdge((int)i, (int)k);
-                }
-            }
+        auto references = m_References->find(keys[i]);
+        for (size_t j = 0; references != m_References->end() && j < references->second.size(); j++)
+        {
+            auto found = indexes.find(Tables::cellKey(references->second[j].first, references->second[j].second));
+            if (found != indexes.end())
+                g.addEdge((int)i, found->second);
+        }
+        //Formulas, which read this one through a range, are counted after it
+        std::vector<std::pair<int, int>> ranges = this->rangeDependents(indFunc[i].first, indFunc[i].second);
+        for (size_t j = 0; j < ranges.size(); j++)
+        {
+            auto found = indexes.find(Tables::cellKey(ranges[j].first, ranges[j].second));
+            if (found != indexes.end())
+                g.addEdge(found->second, (int)i);
+        }
     }
-    return g.topologicalSort();
+
+    std::vector<std::vector<int>> levels = g.levels();
+    std::vector<std::vector<std::pair<int, int>>> ret(levels.size());
+    for (size_t i = 0; i < levels.size(); i++)
+        for (size_t j = 0; j < levels[i].size(); j++)
+            ret[i].push_back(indFunc[levels[i][j]]);
+    return ret;
 }
 
 void Tables::addFormula(const int &row, const int &column, const std::string &src)
 {
-    this->changeSize(row + 1);
     this->changeLineSize(column + 1);
-    m_Table[row].setValueFormula(column, src);
-    Cell *newCell = m_Table[row].getCell(column);
-    std::vector<std::string> formula = newCell->getFormula();
-    for (size_t i = 0; i < formula.size(); i++)
+    Formula formula = Tables::compileFormula(src);
+    size_t length = this->cellLength(row, column);
+    this->releaseFormula(row, column);
+    int index = this->storeFormula(Formula(formula), row, column);
+    this->makeLine(row).setFormula(column, index);
+    this->updateIndex(row, column, length);
+    for (size_t i = 0; i < formula.code.code.size(); i++)
     {
-        if (detectIfIsCell(formula[i]))
+        const Instruction &ins = formula.code.code[i];
+        if (isAggregateOp(ins.op) && ins.row <= row && row <= ins.rowEnd && ins.column <= column && column <= ins.columnEnd)
+        {
+            deleteCell(row, column);
+            throw std::logic_error("Cell formula cannot content itself");
+        }
+        if (ins.op == OpCode::CELL)
         {
-            std::pair<int, int> cord = translateCell(formula[i]);
+            std::pair<int, int> cord(ins.row, ins.column);
             if ((cord.first == row && cord.second == column))
             {
                 deleteCell(row, column);
                 throw std::logic_error("Cell formula cannot content itself");
             }
-            else if (((size_t)cord.first >= m_Table.size() || (size_t)cord.second >= this->maxLineSize))
+            else if (((size_t)cord.first >= m_Rows || (size_t)cord.second >= this->maxLineSize))
             {
                 deleteCell(row, column);
                 throw std::logic_error("Cell in formula doesn't exist");
             }
-            Cell *check = m_Table[cord.first].getCell(cord.second);
+            const Cell *check = this->findCell(cord.first, cord.second);
             if (check == nullptr)
             {
+                std::string name = formula.code.strings[ins.text];
                 deleteCell(row, column);
-                std::transform(formula[i].begin(), formula[i].end(), formula[i].begin(), ::toupper);
-                throw std::logic_error(formula[i] + " is empty");
+                std::transform(name.begin(), name.end(), name.begin(), ::toupper);
+                throw std::logic_error(name + " is empty");
             }
         }
     }
-    for (size_t i = 0; i < m_Formula.size(); i++)
-    {
-        if (m_Formula[i].first == row && m_Formula[i].second == column)
-        {
-            m_Formula.erase(m_Formula.begin() + i);
-            break;
-        }
-    }
-    m_Formula.push_back(std::pair<int, int>(row, column));
-    if (checkCycle())
+    this->linkFormula(row, column);
+    //Inside a transaction cycles are found once by commit
+    if (m_Backup == nullptr && this->checkCycle(row, column))
     {
-        m_Formula.pop_back();
-        m_Table[row].delCell(column);
+        length = this->cellLength(row, column);
+        this->releaseFormula(row, column);
+        this->editLine(row)->delCell(column);
+        this->updateIndex(row, column, length);
         setValue(row, column, "0");
         std::stringstream s;
         translateRow(s, row + 1, column);
         throw std::logic_error("Cycle detected. " + s.str() + "'s value is set to 0");
     }
-    this->updateInsideFormula();
+    Tables::editShared(m_Dirty).insert(Tables::cellKey(row, column));
+    this->markDirty(row, column);
+    if (!m_Deferred)
+        this->updateInsideFormula();
 }
 
-std::string Tables::operation(const std::string &operation, const std::string &firstOp, const std::string &secondOp)
+const Cell *Tables::findCell(const int &row, const int &column) const
 {
-    std::string res;
-    Cell *src1 = nullptr, *src2 = nullptr;
-    if (detectIfIsCell(firstOp))
-    {
-        std::pair<int, int> cellCoordinates = translateCell(firstOp);
-        src1 = m_Table[cellCoordinates.first].getCell(cellCoordinates.second);
-    }
-    if (detectIfIsCell(secondOp))
+    const Line *line = this->findLine(row);
+    if (line == nullptr || column < 0)
+        return nullptr;
+    return line->getCell(column);
+}
+
+Value Tables::evaluate(const Formula &formula, const int &row, const int &column) const
+{
+    //Stack is kept by every thread between evaluations, so it is allocated only when a formula needs a deeper one
+    static thread_local std::vector<Value> stack;
+    if (stack.size() < formula.code.maxStack)
+        stack.resize(formula.code.maxStack);
+    size_t top = 0;
+    for (size_t i = 0; i < formula.code.code.size(); i++)
     {
-        std::pair<int, int> cellCoordinates = translateCell(secondOp);
-        src2 = m_Table[cellCoordinates.first].getCell(cellCoordinates.second);
+        const Instruction &ins = formula.code.code[i];
+        switch (ins.op)
+        {
+        case OpCode::NUMBER:
+            stack[top++] = Value(ins.number);
+            break;
+        case OpCode::STRING:
+            stack[top++] = Value(formula.code.strings[ins.text]);
+            break;
+        case OpCode::CELL:
+        {
+            //Empty cell is counted as a line with its name
+            Instruction moved = formula.instruction(i, row, column);
+            const Cell *src = this->findCell(moved.row, moved.column);
+            if (src != nullptr)
+                stack[top++] = src->getValue();
+            else if (formula.row == row && formula.column == column)
+                stack[top++] = Value(formula.code.strings[ins.text]);
+            else
+                stack[top++] = Value(cellName(moved.row, moved.column));
+            break;
+        }
+        case OpCode::SUM:
+        case OpCode::AVG:
+        case OpCode::MIN:
+        case OpCode::MAX:
+        case OpCode::COUNT:
+            stack[top++] = this->aggregate(formula.instruction(i, row, column));
+            break;
+        case OpCode::SIN:
+        case OpCode::COS:
+        case OpCode::SQRT:
+            if (top == 0)
+                stack[top++] = Value(0.0);
+            stack[top - 1] = stack[top - 1].function(ins.op);
+            break;
+        default:
+            if (top == 0)
+                return Value::error("Not correct formula");
+            if (top == 1)
+                stack[0] = stack[0].operation(ins.op, Value(std::string(" ")));
+            else
+            {
+                stack[top - 2] = stack[top - 2].operation(ins.op, stack[top - 1]);
+                top--;
+            }
+            break;
+        }
     }
+    if (top == 0)
+        return Value::error("Not correct formula");
+    return stack[0];
+}
 
-    if (src1 == nullptr && src2 == nullptr)
+std::vector<Value> Tables::evaluateShared(const Formula &formula, const std::vector<std::pair<int, int>> &cells) const
+{
+    std::vector<Value> ret;
+    size_t count = cells.size();
+    //Stack has a column of numbers on every level, one number for every Cell
+    static thread_local std::vector<double> stack;
+    if (stack.size() < std::max(formula.code.maxStack, (size_t)1) * count)
+        stack.resize(std::max(formula.code.maxStack, (size_t)1) * count);
+    size_t top = 0;
+    bool numbers = count > 1;
+    for (size_t i = 0; i < formula.code.code.size() && numbers; i++)
     {
-        bool isNumbers;
-        if (isNum(firstOp))
-            isNumbers = true;
-        if (isNumbers)
+        const Instruction &ins = formula.code.code[i];
+        switch (ins.op)
+        {
+        case OpCode::NUMBER:
+            std::fill(stack.begin() + (long)(top * count), stack.begin() + (long)((top + 1) * count), ins.number);
+            top++;
+            break;
+        case OpCode::CELL:
+        case OpCode::SUM:
+        case OpCode::AVG:
+        case OpCode::MIN:
+        case OpCode::MAX:
+        case OpCode::COUNT:
         {
-            NumCell src;
-            src.setValue(std::stod(firstOp));
-            res = src.operation(operation, secondOp, true);
+            double *result = stack.data() + top * count;
+            for (size_t k = 0; k < count && numbers; k++)
+            {
+                Instruction moved = formula.instruction(i, cells[k].first, cells[k].second);
+                if (ins.op == OpCode::CELL)
+                {
+                    //Referenced numbers are read from columns without Cells
+                    numbers = (size_t)moved.column < m_Columns.size() && m_Columns[moved.column] != nullptr && m_Columns[moved.column]->isNumber((size_t)moved.row);
+                    result[k] = numbers ? m_Columns[moved.column]->getNumber((size_t)moved.row) : 0;
+                    continue;
+                }
+                Value value = this->aggregate(moved);
+                numbers = value.getType() == ValueType::NUMBER;
+                result[k] = value.getNumber();
+            }
+            top++;
+            break;
         }
-        else
+        case OpCode::SIN:
+        case OpCode::COS:
+        case OpCode::SQRT:
+        {
+            if (top == 0)
+                std::fill(stack.begin(), stack.begin() + (long)count, 0.0);
+            top = std::max(top, (size_t)1);
+            double *result = stack.data() + (top - 1) * count;
+            if (ins.op == OpCode::SIN)
+                for (size_t k = 0; k < count; k++)
+                    result[k] = ::sin(result[k]);
+            else if (ins.op == OpCode::COS)
+                for (size_t k = 0; k < count; k++)
+                    result[k] = ::cos(result[k]);
+            else if (*std::min_element(result, result + count) < 0)
+                numbers = false;
+            else
+                for (size_t k = 0; k < count; k++)
+                    result[k] = ::sqrt(result[k]);
+            break;
+        }
+        case OpCode::ADD:
+        case OpCode::SUB:
+        case OpCode::MUL:
+        case OpCode::DIV:
         {
-            StringCell src;
-            src.setValue(firstOp);
-            res = src.operation(operation, secondOp, true);
+            if (top < 2)
+            {
+                numbers = false;
+                break;
+            }
+            double *first = stack.data() + (top - 2) * count;
+            const double *second = first + count;
+            if (ins.op == OpCode::ADD)
+                for (size_t k = 0; k < count; k++)
+                    first[k] += second[k];
+            else if (ins.op == OpCode::SUB)
+                for (size_t k = 0; k < count; k++)
+                    first[k] -= second[k];
+            else if (ins.op == OpCode::MUL)
+                for (size_t k = 0; k < count; k++)
+                    first[k] *= second[k];
+            else
+                for (size_t k = 0; k < count; k++)
+                    first[k] /= second[k];
+            top--;
+            break;
+        }
+        default:
+            numbers = false;
+            break;
         }
     }
-    else if (src1 != nullptr && src2 == nullptr)
+
+    //Lines, errors and missing operands are counted for every Cell separately
+    if (!numbers || top == 0)
     {
-        res = src1->operation(operation, secondOp, true);
+        for (size_t k = 0; k < count; k++)
+            ret.push_back(this->evaluate(formula, cells[k].first, cells[k].second));
+        return ret;
     }
-    else if (src2 != nullptr && src1 == nullptr)
+    for (size_t k = 0; k < count; k++)
+        ret.push_back(Value(stack[k]));
+    return ret;
+}
+
+Value Tables::aggregate(const Instruction &ins) const
+{
+    //Long range is counted through indexes of its columns without reading Cells
+    bool indexed = ins.rowEnd - ins.row + 1 >= INDEX_ROWS;
+    Aggregate result;
+    for (int j = ins.column; j <= ins.columnEnd && indexed; j++)
     {
-        res = src2->operation(operation, firstOp, false);
+        static const NumberColumn empty;
+        auto index = m_ColumnIndex.find(j);
+        if (index == m_ColumnIndex.end() || index->second == nullptr)
+            indexed = false;
+        else
+            result.add(index->second->query((size_t)ins.row, (size_t)ins.rowEnd, (size_t)j < m_Columns.size() && m_Columns[j] != nullptr ? *m_Columns[j] : empty));
     }
-    else
+
+    if (!indexed)
     {
-        std::stringstream s;
-        src2->print(s);
-        std::string operand = s.str();
-        res = src1->operation(operation, operand, true);
+        //Short range is read from columns of numbers by kernels
+        result = Aggregate();
+        for (int j = ins.column; j <= std::min(ins.columnEnd, (int)m_Columns.size() - 1); j++)
+            if (m_Columns[j] != nullptr)
+                result.add(m_Columns[j]->aggregate((size_t)ins.row, (size_t)ins.rowEnd, ins.op == OpCode::MIN || ins.op == OpCode::MAX));
     }
 
-    return res;
-}
+    if (result.errors != 0)
+    {
+        //Range with an error returns the first error
+        int lastRow = std::min(ins.rowEnd, (int)m_Rows - 1);
+        for (int i = ins.row; i <= lastRow; i++)
+            for (int j = ins.column; j <= ins.columnEnd; j++)
+            {
+                const Cell *src = this->findCell(i, j);
+                if (src != nullptr && src->getValue().getType() == ValueType::ERROR)
+                    return src->getValue();
+            }
+    }
 
-std::string Tables::function(const std::string &operation, const std::string &firstOp)
-{
-    std::string res;
-    Cell *src1 = nullptr;
-    if (detectIfIsCell(firstOp))
+    switch (ins.op)
     {
-        std::pair<int, int> cellCoordinates = translateCell(firstOp);
-        src1 = m_Table[cellCoordinates.first].getCell(cellCoordinates.second);
+    case OpCode::SUM:
+        return Value(result.sum);
+    case OpCode::AVG:
+        if (result.count == 0)
+            return Value::error("Cannot execute avg on a range without numbers");
+        return Value(result.sum / (double)result.count);
+    case OpCode::MIN:
+        return Value(result.count == 0 ? 0.0 : result.min);
+    case OpCode::MAX:
+        return Value(result.count == 0 ? 0.0 : result.max);
+    default:
+        return Value((double)result.count);
     }
+}
+
+void Tables::setDeferred(const bool &deferred)
+{
+    m_Deferred = deferred;
+}
+
+bool Tables::isDeferred() const
+{
+    return m_Deferred;
+}
+
+void Tables::begin()
+{
+    if (m_Backup != nullptr)
+        throw std::logic_error("Transaction is already started");
+    //Copy shares blocks of Lines, columns, indexes of columns and structures of formulas with a table, so only changed ones are copied later
+    m_Backup = std::make_shared<const Tables>(*this);
+}
 
-    if (src1 == nullptr)
+void Tables::commit()
+{
+    if (m_Backup == nullptr)
+        throw std::logic_error("Transaction is not started");
+    std::shared_ptr<const Tables> backup = m_Backup;
+    m_Backup = nullptr;
+    try
     {
-        if (isNum(firstOp))
-        {
-            NumCell src;
-            src.setValue(std::stod(firstOp));
-            res = src.function(operation);
-        }
-        else
-        {
-            throw std::logic_error("Cannot execute " + operation + " on a line");
-        }
+        this->updateInsideFormula();
     }
-    else
+    catch (const std::exception &ex)
     {
-        res = src1->function(operation);
+        *this = *backup;
+        throw std::logic_error(std::string(ex.what()) + ". Transaction is rolled back");
     }
-    return res;
+}
+
+void Tables::rollback()
+{
+    if (m_Backup == nullptr)
+        throw std::logic_error("Transaction is not started");
+    //Backup is held here, because it is released while table is assigned
+    std::shared_ptr<const Tables> backup = m_Backup;
+    *this = *backup;
+}
+
+bool Tables::inTransaction() const
+{
+    return m_Backup != nullptr;
 }
 
 void Tables::updateInsideFormula()
 {
-    std::vector<int> arr = this->topoSort();
-    for (int i = (int)arr.size() - 1; i >= 0; i--)
+    if (m_Dirty->empty() || m_Backup != nullptr)
+        return;
+    this->buildIndexes();
+    std::vector<std::vector<std::pair<int, int>>> levels = this->topoLevels();
+    //Formulas in a cycle and formulas, which read them, are never ready to be counted. They get an error, so table can be used further
+    std::unordered_set<uint64_t> ready;
+    for (size_t i = 0; i < levels.size(); i++)
+        for (size_t j = 0; j < levels[i].size(); j++)
+            ready.insert(Tables::cellKey(levels[i][j].first, levels[i][j].second));
+    size_t cyclic = 0;
+    std::unordered_set<uint64_t> &dirty = Tables::editShared(m_Dirty);
+    for (auto it = dirty.begin(); it != dirty.end();)
+    {
+        if (ready.count(*it) != 0)
+        {
+            ++it;
+            continue;
+        }
+        std::pair<int, int> cell = Tables::keyCell(*it);
+        it = dirty.erase(it);
+        size_t length = this->cellLength(cell.first, cell.second);
+        this->editLine(cell.first)->getCell(cell.second)->setInside(Value::error("Cycle detected"));
+        this->updateIndex(cell.first, cell.second, length);
+        cyclic++;
+    }
+
+    for (size_t i = 0; i < levels.size(); i++)
     {
-        int k = arr[i];
-        Cell *newCell = m_Table[m_Formula[k].first].getCell(m_Formula[k].second);
-        std::vector<std::string> formula = newCell->getFormula();
-        for (size_t j = 0; j < formula.size(); j++)
+        const std::vector<std::pair<int, int>> &level = levels[i];
+        //Formulas of one level don't reference each other, so they can be counted at the same time
+        std::vector<Value> results(level.size());
+        parallelFor(level.size(), EVALUATE_FORMULAS, [this, &level, &results](size_t begin, size_t end) {
+            //Cells, which share a formula, are counted together
+            std::vector<std::pair<int, size_t>> order;
+            for (size_t j = begin; j < end; j++)
+                order.push_back(std::pair<int, size_t>(this->findCell(level[j].first, level[j].second)->getFormula(), j));
+            std::sort(order.begin(), order.end());
+            std::vector<std::pair<int, int>> cells;
+            for (size_t j = 0, k = 0; j < order.size(); j = k)
+            {
+                cells.clear();
+                for (k = j; k < order.size() && order[k].first == order[j].first; k++)
+                    cells.push_back(level[order[k].second]);
+                std::vector<Value> shared = this->evaluateShared((*m_Formulas)[order[j].first], cells);
+                for (size_t l = j; l < k; l++)
+                    results[order[l].second] = shared[l - j];
+            }
+        });
+
+        //Results are saved in the same order on every run, first error stops counting
+        for (size_t j = 0; j < level.size(); j++)
         {
-            if (isOperation(formula[j]))
+            if (results[j].getType() == ValueType::ERROR)
             {
-                if (isFunc(formula[j]))
-                {
-                    if (j == 0)
-                    {
-                        formula.insert(formula.begin() + j, "0");
-                        j++;
-                    }
-                    try
-                    {
-                        formula[j] = this->function(formula[j], formula[j - 1]);
-                        formula.erase(formula.begin() + j - 1);
-                    }
-                    catch (const std::exception &ex)
-                    {
-                        this->deleteCell(m_Formula[k].first, m_Formula[k].second);
-                        throw std::logic_error(ex.what());
-                    }
-                    continue;
-                }
-                if (j < 2)
-                {
-                    if (j == 0)
-                    {
-                        this->deleteCell(m_Formula[k].first, m_Formula[k].second);
-                        throw std::logic_error("Not correct formula");
-                    }
-                    while (j < 2)
-                    {
-                        formula.insert(formula.begin() + j, " ");
-                        j++;
-                    }
-                }
-                try
-                {
-                    formula[j] = this->operation(formula[j], formula[j - 2], formula[j - 1]);
-                }
-                catch (const std::exception &ex)
-                {
-                    this->deleteCell(m_Formula[k].first, m_Formula[k].second);
-                    throw std::logic_error(ex.what());
-                }
-                formula.erase(formula.begin() + j - 2, formula.begin() + j);
-                j = 0;
+                this->deleteCell(level[j].first, level[j].second);
+                throw std::logic_error(results[j].getString());
             }
+            Tables::editShared(m_Dirty).erase(Tables::cellKey(level[j].first, level[j].second));
+            size_t length = this->cellLength(level[j].first, level[j].second);
+            this->editLine(level[j].first)->getCell(level[j].second)->setInside(results[j]);
+            this->updateIndex(level[j].first, level[j].second, length);
         }
-        newCell->setInside(formula[0]);
     }
+    if (cyclic != 0)
+        throw std::logic_error("Cycle detected. " + std::to_string(cyclic) + " formulas cannot be counted");
 }
 #endif // TABLES_CPP
\ No newline at end of file
@@ -12,8 +12,15 @@
 #define TABLES_H
 
 #include <vector>
+#include <unordered_map>
+#include <unordered_set>
+#include <string_view>
+#include <cstdint>
+#include <memory>
 #include "../cell/cell.h"
 #include "../line/line.h"
+#include "../pool/pool.h"
+#include "../aggregate/aggregate.h"
 #include <iostream>
 
 /**
@@ -28,11 +35,25 @@ public:
     Tables();
 
     /**
-     * @brief Construct a new Tables object copied from a source Tables
+     * @brief Construct a new Tables object copied from a source Tables. Cells, columns and structures of formulas are shared, until one of tables changes them, so copy is cheap
      * @param src Tables which needs to be copied
      */
     Tables(const Tables &src);
 
+    /**
+     * @brief Makes Tables a copy of a source Tables. Cells are shared in the same way, as by a copy
+     * @param src Tables which needs to be copied
+     * @return Tables& this Tables
+     */
+    Tables &operator=(const Tables &src);
+
+    /**
+     * @brief Makes Tables a source Tables, source Tables is left empty
+     * @param src Tables which needs to be moved
+     * @return Tables& this Tables
+     */
+    Tables &operator=(Tables &&src);
+
     /**
      * @brief Destroy the Tables object
      */
@@ -60,19 +81,33 @@ public:
     void printRange(const int &row1, const int &column1, const int &row2, const int &column2, bool function = false) const;
 
     /**
-     * @brief Static function, which will print Indexes (upper line with letters)
-     * @param lineLenth Number of elements in a Line
+     * @brief Print one page of a table, which fits to a console. Only Cells of a page are read and page is written to a console at once
+     * @param rowPage number of a page of rows, starting with 1
+     * @param columnPage number of a page of columns, starting with 1
+     */
+    void printPage(const size_t &rowPage, const size_t &columnPage) const;
+
+    /**
+     * @brief Appends part of a table with a header and borders to a given buffer, as it is printed
+     * @param buffer line, where part of a table will be appended
      * @param CellWidth std::vector<size_t> with maxWidth of every Column
-     * @param startWith starting index
+     * @param maxInd width of a column with indexes of rows
+     * @param row1 first appended row
+     * @param row2 last appended row
+     * @param column1 first appended column
+     * @param column2 last appended column
      */
-    static void printInd(const size_t &lineLenth, const std::vector<size_t> &CellWidth, int startWith = 0);
+    void appendFrame(std::string &buffer, const std::vector<size_t> &CellWidth, const size_t &maxInd, const size_t &row1, const size_t &row2, const size_t &column1, const size_t &column2) const;
 
     /**
-     * @brief Prints line ('-')
-     * @param fullSize Number of elements*CellWidth in a Line
-     * @param maxInd Max row index in a Table
+     * @brief Appends formulas from a part of a table to a given buffer, as they are printed
+     * @param buffer line, where formulas will be appended
+     * @param row1 first appended row
+     * @param row2 last appended row
+     * @param column1 first appended column
+     * @param column2 last appended column, 0 means till the end of a Line
      */
-    static void printLine(const size_t &fullSize, const size_t &maxInd);
+    void appendFormulas(std::string &buffer, const size_t &row1, const size_t &row2, const size_t &column1, const size_t &column2) const;
 
     /**
      * @brief Set the value to a Cell in the Table
@@ -89,10 +124,38 @@ public:
     void exportTable(std::ofstream &outFile) const;
 
     /**
-     * @brief Import Table from a std::ifstream
-     * @param inFile std::ifstream, where source Table is
+     * @brief Import Table from a file. File is mapped to memory and read without copying
+     * @param fileName path to a file, where source Table is
+     */
+    void importTable(const std::string &fileName);
+
+    /**
+     * @brief Import Table from a buffer in the same format as exported file
+     * @param data content of an exported file
+     */
+    void importTable(std::string_view data);
+
+    /**
+     * @brief Exports Table to a given std::ofstream as a binary snapshot with typed values, compiled formulas and their results
+     * @param outFile std::ofstream opened in binary mode, where Tables ought to be exported to
+     */
+    void exportBinary(std::ofstream &outFile) const;
+
+    /**
+     * @brief Import Table from a binary snapshot file. Formulas are not counted again
+     * @param fileName path to a file, where snapshot is
      */
-    void importTable(std::ifstream &inFile);
+    void importBinary(const std::string &fileName);
+
+    /**
+     * @brief Import Table from a buffer with a binary snapshot. Table is changed only if the whole snapshot is correct
+     * @param data content of a snapshot
+     * @exception if snapshot is not correct or has another version throws an exception
+     */
+    void importBinary(std::string_view data);
+
+    //!> version of a binary snapshot, which is written and can be read
+    static constexpr uint32_t SNAPSHOT_VERSION = 2;
 
     /**
      * @brief Delete Table
@@ -137,28 +200,63 @@ public:
     void copyValue(const int &row1, const int &column1, const int &row2, const int &column2);
 
     /**
-     * @brief Change numbers of rows
+     * @brief Change numbers of rows. Lines themselves are allocated on first write
      * @param newSize new number of Lines
      */
     void changeSize(const int &newSize);
 
     /**
-     * @brief Change numbers of columns
+     * @brief Change numbers of columns. Cells themselves are allocated on first write
      * @param newSize new number of columns
      */
     void changeLineSize(const int &newSize);
 
     /**
-     * @brief Add CellFunc in a Table
+     * @brief Add formula in a Table
      * 
-     * @param row row's index, where CellFunc will be
-     * @param column column's index, where CellFunc will be
+     * @param row row's index, where formula will be
+     * @param column column's index, where formula will be
      * @param src function, which will be set
      */
     void addFormula(const int &row, const int &column, const std::string &src);
 
     /**
-     * @brief Countes formulas
+     * @brief Set whether formulas are counted after every change or only when updateInsideFormula is called
+     * @param deferred true if formulas are not counted after a change
+     */
+    void setDeferred(const bool &deferred);
+
+    /**
+     * @brief Detects if counting of formulas is deferred
+     * @return true formulas are counted only by updateInsideFormula
+     * @return false formulas are counted after every change
+     */
+    bool isDeferred() const;
+
+    /**
+     * @brief Starts a transaction. Table is saved, formulas are not checked for cycles and not counted till commit
+     */
+    void begin();
+
+    /**
+     * @brief Ends a transaction. Cycles are found and formulas are counted once, table is returned to its state before begin, if there is an error
+     */
+    void commit();
+
+    /**
+     * @brief Ends a transaction and returns table to its state before begin
+     */
+    void rollback();
+
+    /**
+     * @brief Detects if transaction is started
+     * @return true changes are made inside a transaction
+     * @return false transaction is not started
+     */
+    bool inTransaction() const;
+
+    /**
+     * @brief Countes formulas, which were changed or depend on changed cells. Formulas are not counted inside a transaction
      * 
      */
     void updateInsideFormula();
@@ -172,48 +270,336 @@ public:
     void deleteDepended(const int &row1, const int &column1);
 
     /**
-     * @brief Detects, if formulas have cycles
-     * 
+     * @brief Detects, if a new formula made a cycle. Only formulas, which read a new formula, are searched till a Cell read by a new formula is found
+     *
+     * @param row row, where new formula is situated
+     * @param column column, where new formula is situated
      * @return true Formulas does contain cycle
      * @return false Formulas doesn't contain cycle
      */
-    bool checkCycle();
+    bool checkCycle(const int &row, const int &column);
 
     /**
-     * @brief Topological sort of formulas
-     * 
-     * @return std::vector<int> order, in which formulas will be counted
+     * @brief Splits formulas, which need to be counted again, to levels. Formulas of one level don't reference each other
+     *
+     * @return std::vector<std::vector<std::pair<int, int>>> levels of cells in order, in which they will be counted
      */
-    std::vector<int> topoSort();
+    std::vector<std::vector<std::pair<int, int>>> topoLevels();
 
     /**
-     * @brief Execute math operation
-     * 
-     * @param operation math operation which will be executed
-     * @param firstOp first operand
-     * @param secondOp second operand
-     * @return std::string result of an operation
+     * @brief Counts compiled formula for a Cell
+     *
+     * @param formula formula, which will be counted
+     * @param row row, where Cell with formula is situated
+     * @param column column, where Cell with formula is situated
+     * @return Value result of a formula or error Value, if formula cannot be counted
      */
-    std::string operation(const std::string &operation, const std::string &firstOp, const std::string &secondOp);
+    Value evaluate(const Formula &formula, const int &row, const int &column) const;
 
     /**
-     * @brief Execute function
-     * 
-     * @param operation function which will be executed
-     * @param firstOp operand on which function will be executed
-     * @return std::string result of a function
+     * @brief Counts formula shared by several Cells at once. If all values are numbers, every instruction is one loop over Cells, otherwise Cells are counted one by one
+     *
+     * @param formula formula, which will be counted
+     * @param cells Cells, which share formula
+     * @return std::vector<Value> results of a formula in the same order as Cells
+     */
+    std::vector<Value> evaluateShared(const Formula &formula, const std::vector<std::pair<int, int>> &cells) const;
+
+    /**
+     * @brief Counts aggregate function over a range. Only numbers are counted, empty Cells and lines are skipped
+     *
+     * @param ins instruction with an aggregate function and a range
+     * @return Value result of a function or error Value, if function cannot be counted
+     */
+    Value aggregate(const Instruction &ins) const;
+
+    /**
+     * @brief Get the Cell from a Table
+     *
+     * @param row row, where Cell is situated
+     * @param column column, where Cell is situated
+     * @return const Cell* needed Cell or nullptr if Cell is empty
      */
-    std::string function(const std::string &operation, const std::string &firstOp);
+    const Cell *findCell(const int &row, const int &column) const;
+
+    //!> number of Lines in one block of a table
+    static const size_t BLOCK_SIZE = 64;
+
+    //!> size of a buffer, after which exported table is written to a file
+    static constexpr size_t EXPORT_BUFFER = 1 << 20;
+
+    //!> width of a console, which is used by printPage, if it cannot be detected
+    static constexpr size_t PAGE_WIDTH = 80;
+
+    //!> height of a console, which is used by printPage, if it cannot be detected
+    static constexpr size_t PAGE_HEIGHT = 24;
+
+    //!> minimal number of rows of a range, which is counted through column indexes. Shorter range reads only a few blocks of a column
+    static constexpr int INDEX_ROWS = 4 * (int)NumberColumn::BLOCK_ROWS;
+
+    //!> minimal number of formulas of one level, which are counted by one thread
+    static constexpr size_t EVALUATE_FORMULAS = 64;
+
+    //!> minimal number of blocks of Lines, which are imported by one thread
+    static constexpr size_t IMPORT_BLOCKS = 16;
+
+    //!> minimal number of formulas, which are compiled by one thread
+    static constexpr size_t IMPORT_FORMULAS = 256;
 
 private:
-    //!> Table itself with rows and columns
-    std::vector<Line> m_Table;
+    //!> Table itself with rows and columns, split to blocks of Lines, not allocated block is nullptr. Block can be shared with copies of a table
+    std::vector<std::shared_ptr<std::vector<Line>>> m_Table;
+
+    //!> chunks of Cells of all Lines, shared with copies of a table. It is after m_Table, so old Lines are released to it before it is changed
+    std::shared_ptr<CellPool> m_Pool;
+
+    //!> number of rows in a table
+    size_t m_Rows;
 
     //!> number of Cells in a line (basically a size of a Line)
     size_t maxLineSize;
 
-    //!> indexes of CellFunc in table
-    std::vector<std::pair<int, int>> m_Formula;
+    //!> indexes of formulas in table, order is not kept. Shared with copies of a table like all structures of formulas below
+    std::shared_ptr<std::vector<std::pair<int, int>>> m_Formula;
+
+    //!> position of a formula in m_Formula by its packed row and column
+    std::shared_ptr<std::unordered_map<uint64_t, size_t>> m_FormulaIndex;
+
+    //!> Formulas, which are referenced by Cells, one Formula can be shared by Cells of one column
+    std::shared_ptr<std::vector<Formula>> m_Formulas;
+
+    //!> indexes of unused Formulas in m_Formulas
+    std::shared_ptr<std::vector<int>> m_FreeFormulas;
+
+    //!> cells, which are referenced by a formula, formula is found by cellKey
+    std::shared_ptr<std::unordered_map<uint64_t, std::vector<std::pair<int, int>>>> m_References;
+
+    //!> cellKeys of formulas, which reference a cell, cell is found by cellKey
+    std::shared_ptr<std::unordered_map<uint64_t, std::unordered_set<uint64_t>>> m_Dependents;
+
+    //!> cellKeys of formulas, which need to be counted again
+    std::shared_ptr<std::unordered_set<uint64_t>> m_Dirty;
+
+    //!> true if changed formulas are not counted till updateInsideFormula is called
+    bool m_Deferred;
+
+    //!> table, as it was before a transaction, nullptr if transaction is not started
+    std::shared_ptr<const Tables> m_Backup;
+
+    /**
+     * @brief Range of Cells, which is read by a formula
+     */
+    struct RangeReference
+    {
+        //!> first row of a range
+        int row1;
+
+        //!> first column of a range
+        int column1;
+
+        //!> last row of a range
+        int row2;
+
+        //!> last column of a range
+        int column2;
+
+        //!> formula, which reads a range
+        std::pair<int, int> formula;
+    };
+
+    //!> ranges read by formulas, saved once for every column, which range covers
+    std::shared_ptr<std::unordered_map<int, std::vector<RangeReference>>> m_RangeDependents;
+
+    //!> indexes of columns, which are read by long ranges, nullptr if index is not built yet. Index can be shared with copies of a table
+    std::unordered_map<int, std::shared_ptr<ColumnIndex>> m_ColumnIndex;
+
+    //!> numbers of every column saved one after another, copy of numbers in Cells. Column can be shared with copies of a table
+    std::vector<std::shared_ptr<NumberColumn>> m_Columns;
+
+    //!> widths of printed Cells of every column. Column can be shared with copies of a table
+    std::vector<std::shared_ptr<ColumnWidth>> m_Widths;
+
+    /**
+     * @brief Get the width of the widest Cell in a column
+     *
+     * @param column column of a table
+     * @return size_t number of symbols, 0 if column is empty
+     */
+    size_t columnWidth(const size_t &column) const;
+
+    /**
+     * @brief Get the column, which will be written to. Column is made if it is nullptr and copied if it is shared with a copy of a table
+     *
+     * @tparam T type of a column
+     * @param column column of a table
+     * @return T& column, which is used only by this table
+     */
+    template <typename T>
+    static T &editShared(std::shared_ptr<T> &column);
+
+    /**
+     * @brief Saves changed Cell to its column of numbers, its column of widths and to an index of its column, if column has one
+     *
+     * @param row row, where Cell is situated
+     * @param column column, where Cell is situated
+     * @param oldLength number of symbols of a printed Cell before the change
+     */
+    void updateIndex(const int &row, const int &column, const size_t &oldLength);
+
+    /**
+     * @brief Get the number of symbols of a printed Cell
+     *
+     * @param row row, where Cell is situated
+     * @param column column, where Cell is situated
+     * @return size_t number of symbols, 0 if Cell is empty
+     */
+    size_t cellLength(const int &row, const int &column) const;
+
+    /**
+     * @brief Reads a binary snapshot into an empty table
+     * @param data content of a snapshot
+     * @exception if snapshot is not correct or has another version throws an exception
+     */
+    void loadBinary(std::string_view data);
+
+    /**
+     * @brief Fills columns of numbers from all Cells of a table
+     */
+    void buildColumns();
+
+    /**
+     * @brief Builds indexes of columns, which are read by long ranges, but are not built yet
+     */
+    void buildIndexes();
+
+    /**
+     * @brief Finds formulas, which read a Cell through a range
+     *
+     * @param row row, where Cell is situated
+     * @param column column, where Cell is situated
+     * @return std::vector<std::pair<int, int>> formulas, which read a Cell
+     */
+    std::vector<std::pair<int, int>> rangeDependents(const int &row, const int &column) const;
+
+    /**
+     * @brief Finds formulas inside a range
+     *
+     * @param ins instruction with a range
+     * @return std::vector<std::pair<int, int>> formulas inside a range
+     */
+    std::vector<std::pair<int, int>> formulasInRange(const Instruction &ins) const;
+
+    /**
+     * @brief Get the Line from a table
+     *
+     * @param row index of a Line
+     * @return const Line* needed Line or nullptr, if Line was never written to
+     */
+    const Line *findLine(const int &row) const;
+
+    /**
+     * @brief Get the Line from a table, which will be changed. Block shared with a copy of a table is copied first
+     *
+     * @param row index of a Line
+     * @return Line* needed Line or nullptr, if Line was never written to
+     */
+    Line *editLine(const int &row);
+
+    /**
+     * @brief Get the block of Lines, which will be changed. Not allocated block is made from empty Lines, block shared with a copy of a table is copied
+     *
+     * @param block index of a block
+     * @return std::vector<Line>& Lines of a block, which only this table has
+     */
+    std::vector<Line> &makeBlock(const size_t &block);
+
+    /**
+     * @brief Get the Line, which will be written to. Allocates block of Lines if it is needed
+     *
+     * @param row index of a Line
+     * @return Line& needed Line
+     */
+    Line &makeLine(const int &row);
+
+    /**
+     * @brief Saves compiled formula of a Cell to m_Formulas. If Cell above has the same formula with moved references, its formula is shared
+     *
+     * @param newFormula formula, which was already compiled
+     * @param row row, where Cell is situated
+     * @param column column, where Cell is situated
+     * @return int index of a Formula in m_Formulas
+     */
+    int storeFormula(Formula &&newFormula, const int &row, const int &column);
+
+    /**
+     * @brief Detects if a Cell can share formula, which is already saved
+     *
+     * @param shared formula, which is already saved
+     * @param newFormula compiled formula of a Cell
+     * @param row row, where Cell is situated
+     * @param column column, where Cell is situated
+     * @return true formula moved to a Cell is the same as Cell's formula
+     * @return false formulas are different
+     */
+    static bool sameFormula(const Formula &shared, const Formula &newFormula, const int &row, const int &column);
+
+    /**
+     * @brief Compiles formula. Doesn't change a table, so it can be called from multiple threads
+     *
+     * @param src formula, which will be compiled
+     * @return Formula compiled formula
+     * @exception if formula is not correct throws an exception
+     */
+    static Formula compileFormula(const std::string &src);
+
+    /**
+     * @brief Removes formula, which is in a Cell, from a table's formulas. Cell itself stays unchanged
+     *
+     * @param row row, where Cell is situated
+     * @param column column, where Cell is situated
+     */
+    void releaseFormula(const int &row, const int &column);
+
+    /**
+     * @brief Packs row and column of a Cell to one key
+     *
+     * @param row row, where Cell is situated
+     * @param column column, where Cell is situated
+     * @return uint64_t key of a Cell
+     */
+    static uint64_t cellKey(const int &row, const int &column);
+
+    /**
+     * @brief Unpacks row and column of a Cell from its key. Reverse of cellKey
+     *
+     * @param key key of a Cell
+     * @return std::pair<int, int> row and column of a Cell
+     */
+    static std::pair<int, int> keyCell(const uint64_t &key);
+
+    /**
+     * @brief Registers a formula and saves its references to a dependency graph
+     *
+     * @param row row, where formula is situated
+     * @param column column, where formula is situated
+     */
+    void linkFormula(const int &row, const int &column);
+
+    /**
+     * @brief Unregisters a formula and removes its references from a dependency graph
+     *
+     * @param row row, where formula is situated
+     * @param column column, where formula is situated
+     */
+    void unlinkFormula(const int &row, const int &column);
+
+    /**
+     * @brief Marks all formulas, which depend on a cell, to be counted again
+     *
+     * @param row row, where changed cell is situated
+     * @param column column, where changed cell is situated
+     */
+    void markDirty(const int &row, const int &column);
 };
 
 #endif // TABLES_H
@@ -0,0 +1,213 @@
+/**
+ * @file value.cpp
+ * @author Daria Tiurina (tiuridar@fit.cvut.cz)
+ * @brief Implementation of class Value
+ * @version 1.0
+ * @date 2023-06-05
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+#ifndef VALUE_CPP
+#define VALUE_CPP
+#include "value.h"
+#include <cmath>
+#include <sstream>
+#include <charconv>
+
+/**
+ * @brief Helping function, which returns how operation is written in a formula
+ *
+ * @param operation operation's code
+ * @return std::string operation as it is written
+ */
+static std::string operationName(const OpCode &operation)
+{
+    switch (operation)
+    {
+    case OpCode::ADD:
+        return "+";
+    case OpCode::SUB:
+        return "-";
+    case OpCode::MUL:
+        return "*";
+    case OpCode::DIV:
+        return "/";
+    case OpCode::SIN:
+        return "sin";
+    case OpCode::COS:
+        return "cos";
+    case OpCode::SQRT:
+        return "sqrt";
+    default:
+        return "";
+    }
+}
+
+Value::Value() : m_Type(ValueType::STRING), m_Number(0), m_String("") {}
+
+Value::Value(const double &number) : m_Type(ValueType::NUMBER), m_Number(number), m_String("") {}
+
+Value::Value(const std::string &line) : m_Type(ValueType::STRING), m_Number(0), m_String(line) {}
+
+Value Value::error(const std::string &message)
+{
+    Value ret(message);
+    ret.m_Type = ValueType::ERROR;
+    return ret;
+}
+
+ValueType Value::getType() const
+{
+    return m_Type;
+}
+
+double Value::getNumber() const
+{
+    return m_Number;
+}
+
+const std::string &Value::getString() const
+{
+    return m_String;
+}
+
+void Value::print(std::ostream &os) const
+{
+    if (m_Type != ValueType::NUMBER)
+    {
+        os << m_String;
+        return;
+    }
+    double intpart, fpart;
+    fpart = modf(m_Number, &intpart);
+    if (fpart != 0 || !std::isfinite(m_Number))
+    {
+        os << m_Number;
+    }
+    else
+    {
+        long int intp = (long int)intpart;
+        os << intp;
+    }
+}
+
+void Value::appendTo(std::string &buffer) const
+{
+    if (m_Type != ValueType::NUMBER)
+    {
+        buffer += m_String;
+        return;
+    }
+    char number[32];
+    std::to_chars_result res;
+    double intpart, fpart;
+    fpart = modf(m_Number, &intpart);
+    //Same format as printed by ostream with default precision
+    if (fpart != 0 || !std::isfinite(m_Number))
+        res = std::to_chars(number, number + sizeof(number), m_Number, std::chars_format::general, 6);
+    else
+        res = std::to_chars(number, number + sizeof(number), (long int)intpart);
+    buffer.append(number, res.ptr);
+}
+
+size_t Value::getLength() const
+{
+    if (m_Type != ValueType::NUMBER)
+        return m_String.size();
+    char number[32];
+    double intpart, fpart;
+    fpart = modf(m_Number, &intpart);
+    //Number is measured without making a line, integer part and fractional part with 6 digits, as by std::to_string
+    size_t length = (size_t)(std::to_chars(number, number + sizeof(number), (long int)intpart).ptr - number);
+    if (fpart != 0)
+        length += (size_t)(std::to_chars(number, number + sizeof(number), fpart, std::chars_format::fixed, 6).ptr - number) - 1;
+    return length;
+}
+
+std::string Value::toString() const
+{
+    if (m_Type != ValueType::NUMBER)
+        return m_String;
+    std::stringstream s;
+    this->print(s);
+    return s.str();
+}
+
+Value Value::operation(const OpCode &operation, const Value &operand) const
+{
+    if (m_Type == ValueType::ERROR)
+        return *this;
+    if (operand.m_Type == ValueType::ERROR)
+        return operand;
+
+    if (m_Type == ValueType::NUMBER && operand.m_Type == ValueType::NUMBER)
+    {
+        switch (operation)
+        {
+        case OpCode::ADD:
+            return Value(m_Number + operand.m_Number);
+        case OpCode::SUB:
+            return Value(m_Number - operand.m_Number);
+        case OpCode::MUL:
+            return Value(m_Number * operand.m_Number);
+        case OpCode::DIV:
+            return Value(m_Number / operand.m_Number);
+        default:
+            return Value::error("Not correct formula");
+        }
+    }
+
+    //At least one of operands is a line
+    switch (operation)
+    {
+    case OpCode::ADD:
+        return Value(this->toString() + operand.toString());
+    case OpCode::SUB:
+        return *this;
+    case OpCode::MUL:
+    {
+        if (m_Type == ValueType::STRING && operand.m_Type == ValueType::STRING)
+            break;
+        const std::string &line = m_Type == ValueType::STRING ? m_String : operand.m_String;
+        int times = (int)(m_Type == ValueType::NUMBER ? m_Number : operand.m_Number);
+        std::string ret;
+        for (int i = 0; i < times; i++)
+            ret += line;
+        return Value(ret);
+    }
+    default:
+        break;
+    }
+    return Value::error("Cannot execute " + operationName(operation) + " on a line");
+}
+
+Value Value::function(const OpCode &operation) const
+{
+    if (m_Type == ValueType::ERROR)
+        return *this;
+    if (m_Type != ValueType::NUMBER)
+        return Value::error("Cannot execute " + operationName(operation) + " on a line");
+
+    switch (operation)
+    {
+    case OpCode::SIN:
+        return Value(::sin(m_Number));
+    case OpCode::COS:
+        return Value(::cos(m_Number));
+    case OpCode::SQRT:
+        if (m_Number < 0)
+            return Value::error("Cannot execute sqrt on a negative number");
+        return Value(::sqrt(m_Number));
+    default:
+        return Value::error("Not correct formula");
+    }
+}
+
+std::ostream &operator<<(std::ostream &os, const Value &src)
+{
+    src.print(os);
+    return os;
+}
+
+#endif // VALUE_CPP
@@ -0,0 +1,138 @@
+/**
+ * @file value.h
+ * @author Daria Tiurina (tiuridar@fit.cvut.cz)
+ * @brief Declaration of class Value
+ * @version 1.0
+ * @date 2023-06-05
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+#ifndef VALUE_H
+#define VALUE_H
+
+#include <string>
+#include <iostream>
+#include "../operators/operators.h"
+
+/**
+ * @brief Types of a Value
+ *
+ */
+enum class ValueType : unsigned char
+{
+    NUMBER, //!< number
+    STRING, //!< word or sentence
+    ERROR   //!< error, which happened while counting
+};
+
+/**
+ * @brief Class Value, which defines data inside a Cell or a result of a formula
+ *
+ */
+class Value
+{
+public:
+    /**
+     * @brief Construct a new empty Value object
+     */
+    Value();
+
+    /**
+     * @brief Construct a new Value object with a number
+     * @param number number, which will be inside
+     */
+    Value(const double &number);
+
+    /**
+     * @brief Construct a new Value object with a line
+     * @param line word or sentence, which will be inside
+     */
+    Value(const std::string &line);
+
+    /**
+     * @brief Construct a new Value object with an error
+     * @param message description of an error
+     * @return Value error Value
+     */
+    static Value error(const std::string &message);
+
+    /**
+     * @brief Returns type of a Value
+     * @return ValueType type of a Value
+     */
+    ValueType getType() const;
+
+    /**
+     * @brief Get the number from a Value
+     * @return double number, 0 if Value is not a number
+     */
+    double getNumber() const;
+
+    /**
+     * @brief Get the line or error's description from a Value
+     * @return const std::string& line, empty if Value is a number
+     */
+    const std::string &getString() const;
+
+    /**
+     * @brief Prints Value to a given ostream
+     * @param os ostream, where Value will be printed
+     */
+    void print(std::ostream &os) const;
+
+    /**
+     * @brief Appends Value to a given buffer in the same way, as it is printed
+     * @param buffer line, where Value will be appended
+     */
+    void appendTo(std::string &buffer) const;
+
+    /**
+     * @brief Get the length of a printed Value
+     * @return size_t number of symbols
+     */
+    size_t getLength() const;
+
+    /**
+     * @brief Converts Value to a line, as it is printed
+     * @return std::string printed Value
+     */
+    std::string toString() const;
+
+    /**
+     * @brief Execute math operation, where this Value is first operand
+     *
+     * @param operation which operation needs to be executed
+     * @param operand second operand
+     * @return Value result of an operation or error, if operation cannot be executed
+     */
+    Value operation(const OpCode &operation, const Value &operand) const;
+
+    /**
+     * @brief Execute function on a Value
+     *
+     * @param operation which function needs to be executed
+     * @return Value result of a function or error, if function cannot be executed
+     */
+    Value function(const OpCode &operation) const;
+
+private:
+    //!> type of a Value
+    ValueType m_Type;
+
+    //!> number, if Value is a number
+    double m_Number;
+
+    //!> line or error's description
+    std::string m_String;
+};
+
+/**
+ * @brief Output operator to a given ostream
+ * @param os ostream, where Value will be printed
+ * @param src Value which needs to be printed
+ * @return std::ostream&
+ */
+std::ostream &operator<<(std::ostream &os, const Value &src);
+
+#endif // VALUE_H
@@ -0,0 +1,144 @@
+#include <iostream>
+#include <chrono>
+#include <string>
+#include <fstream>
+#include <iomanip>
+#include <fcntl.h>
+#include <unistd.h>
+#include "../src/tables/tables.h"
+#include "../src/aggregate/aggregate.h"
+
+//!> number of rows in a benchmarked column
+static const int ROWS = 1000000;
+
+//!> number of times every sum is counted
+static const int REPEAT = 20;
+
+//!> number of rows and columns in a benchmarked frame
+static const int FRAME_ROWS = 60;
+static const int FRAME_COLUMNS = 12;
+
+//!> number of times every frame is printed
+static const int FRAMES = 2000;
+
+/**
+ * @brief Measures how many Cells per second are summed by a function
+ *
+ * @param name name of a layout, which is printed
+ * @param sum function, which sums a column once
+ */
+template <typename F>
+static void measure(const std::string &name, F sum)
+{
+    double result = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < REPEAT; i++)
+        result += sum();
+    std::chrono::duration<double> time = std::chrono::steady_clock::now() - start;
+    std::cout << name << ": " << (double)ROWS * REPEAT / time.count() / 1e6 << " M cells/s (sum " << result / REPEAT << ")" << std::endl;
+}
+
+/**
+ * @brief Measures how many frames per second are printed by a function
+ *
+ * @param name name of a way of printing, which is printed
+ * @param print function, which prints a frame once
+ */
+template <typename F>
+static void measureFrames(const std::string &name, F print)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < FRAMES; i++)
+        print();
+    std::chrono::duration<double> time = std::chrono::steady_clock::now() - start;
+    std::cout << name << ": " << FRAMES / time.count() << " frames/s" << std::endl;
+}
+
+/**
+ * @brief Prints a frame with std::setw for every Cell and std::endl for every line, as a table was printed before
+ *
+ * @param os ostream, where frame is printed
+ * @param table printed table
+ * @param CellWidth widths of columns
+ * @param maxInd width of a column with indexes of rows
+ */
+static void printStream(std::ostream &os, const Tables &table, const std::vector<size_t> &CellWidth, const size_t &maxInd)
+{
+    size_t fullSize = 1;
+    for (size_t j = 0; j < CellWidth.size(); j++)
+        fullSize += CellWidth[j] + 1;
+    for (int i = 0; i < FRAME_ROWS; i++)
+    {
+        os << "|" << std::setw((int)maxInd + 1) << i + 1 << "|";
+        os << "|";
+        for (int j = 0; j < FRAME_COLUMNS; j++)
+        {
+            os << std::setw((int)CellWidth[j]);
+            const Cell *src = table.findCell(i, j);
+            if (src != nullptr)
+                src->print(os);
+            else
+                os << " ";
+            os << "|";
+        }
+        os << std::endl;
+        for (size_t j = 0; j < fullSize + maxInd + 3; j++)
+            os << '-';
+        os << std::endl;
+    }
+}
+
+int main()
+{
+    Tables table;
+    NumberColumn column;
+    for (int i = 0; i < ROWS; i++)
+    {
+        table.setValue(i, 0, std::to_string(i % 1000));
+        column.set((size_t)i, Value((double)(i % 1000)));
+    }
+
+    measure("rows of Cells", [&table]() {
+        double ret = 0;
+        for (int i = 0; i < ROWS; i++)
+        {
+            const Cell *src = table.findCell(i, 0);
+            if (src != nullptr && src->getValue().getType() == ValueType::NUMBER)
+                ret += src->getValue().getNumber();
+        }
+        return ret;
+    });
+
+    measure("column of numbers", [&column]() {
+        return column.aggregate(0, ROWS - 1, false).sum;
+    });
+
+    Instruction ins = {OpCode::SUM, 0, 0, ROWS - 1, 0, -1, 0};
+    measure("table sum ( a1:a" + std::to_string(ROWS) + " )", [&table, &ins]() {
+        return table.aggregate(ins).getNumber();
+    });
+
+    Tables frame;
+    for (int i = 0; i < FRAME_ROWS; i++)
+        for (int j = 0; j < FRAME_COLUMNS; j++)
+            frame.setValue(i, j, (i + j) % 3 == 0 ? "text" + std::to_string(j) : std::to_string((i * 37 + j) % 10000) + ".5");
+    std::vector<size_t> CellWidth(FRAME_COLUMNS, 8);
+    const size_t maxInd = 3;
+
+    //Frames are printed to /dev/null, so only formatting and writing are measured
+    std::ofstream stream("/dev/null");
+    measureFrames("frame through std::setw", [&]() {
+        printStream(stream, frame, CellWidth, maxInd);
+    });
+
+    int output = open("/dev/null", O_WRONLY);
+    std::string buffer;
+    measureFrames("frame in one buffer", [&]() {
+        buffer.clear();
+        frame.appendFrame(buffer, CellWidth, maxInd, 0, FRAME_ROWS - 1, 0, FRAME_COLUMNS - 1);
+        if (write(output, buffer.data(), buffer.size()) < 0)
+            std::cout << "Frame cannot be written" << std::endl;
+    });
+    close(output);
+    return EXIT_SUCCESS;
+}
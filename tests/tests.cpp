@@ -1,8 +1,20 @@
 #include <iostream>
 #include <assert.h>
+#include <fstream>
+#include <cstdio>
+#include <sstream>
+#include <set>
+#include <mutex>
+#include <thread>
+#include <atomic>
 #include "../src/cell/cell.h"
 #include "../src/commands/commands.h"
+#include "../src/execute/execute.h"
 #include "../src/tables/tables.h"
+#include "../src/graph/graph.h"
+#include "../src/help/help.h"
+#include "../src/aggregate/aggregate.h"
+#include "../src/pool/pool.h"
 
 int main()
 {
@@ -12,31 +24,394 @@ int main()
     testTable.setValue(0, 0, "Ahoj");
     assert(testTable.isEmpty() == false);
 
-    bool exceptionThrown = false;
+    Cell stringTest;
+    stringTest.setString("");
+    assert(stringTest.getType() == CellType::STRING);
+    assert(stringTest.function(OpCode::SIN).getType() == ValueType::ERROR);
 
+    Cell numTest;
+    numTest.setNumber(0);
+    assert(numTest.operation(OpCode::DIV, Value("a"), false).getType() == ValueType::ERROR);
+
+    Cell precisionTest;
+    precisionTest.setNumber(0.1);
+    Value sum = precisionTest.operation(OpCode::ADD, Value(0.0000001), true);
+    assert(sum.getType() == ValueType::NUMBER && sum.getNumber() == 0.1 + 0.0000001);
+
+    testTable.setValue(0, 1, "3");
+    testTable.addFormula(0, 2, "b1 * 2 + 1");
+    testTable.setValue(0, 1, "4");
+    testTable.updateInsideFormula();
+    assert(testTable.findCell(0, 2)->getValue().getNumber() == 9);
+
+    testTable.setValue(100000, 500, "1");
+    assert(testTable.findCell(50000, 3) == nullptr);
+    assert(testTable.findCell(100000, 500)->getValue().getNumber() == 1);
+    testTable.deleteCell(100000, 500);
+    testTable.deleteEmpty();
+    assert(testTable.findCell(100000, 500) == nullptr);
+
+    CellPool poolTest;
+    Cell *chunk = poolTest.allocate();
+    chunk[3].setNumber(5);
+    poolTest.release(chunk);
+    assert(poolTest.allocate() == chunk && chunk[3].isEmpty());
+    testTable.deleteAll();
+    testTable.setValue(3, 20, "7");
+    assert(testTable.findCell(3, 20)->getValue().getNumber() == 7);
+
+    Tables original;
+    original.setValue(0, 0, "1");
+    original.addFormula(0, 1, "a1 * 2");
+    Tables copyTest(original);
+    original.setValue(0, 0, "5");
+    original.updateInsideFormula();
+    assert(copyTest.findCell(0, 0)->getValue().getNumber() == 1 && copyTest.findCell(0, 1)->getValue().getNumber() == 2);
+    copyTest.setValue(0, 0, "3");
+    copyTest.updateInsideFormula();
+    assert(copyTest.findCell(0, 1)->getValue().getNumber() == 6 && original.findCell(0, 1)->getValue().getNumber() == 10);
+    original.deleteAll();
+    assert(copyTest.findCell(0, 1)->getType() == CellType::FORMULA);
+    original = copyTest;
+    copyTest.deleteAll();
+    assert(original.findCell(0, 1)->getValue().getNumber() == 6);
+
+    original.begin();
+    original.addFormula(0, 2, "b1 + 1");
+    original.setValue(0, 0, "4");
+    assert(original.findCell(0, 1)->getValue().getNumber() == 6);
+    original.commit();
+    assert(original.findCell(0, 2)->getValue().getNumber() == 9);
+    original.begin();
+    original.setValue(0, 0, "2");
+    original.addFormula(0, 0, "c1 * 2");
+    bool rolledBack = false;
+    try
+    {
+        original.commit();
+    }
+    catch (const std::logic_error &ex)
+    {
+        rolledBack = true;
+    }
+    assert(rolledBack && !original.inTransaction());
+    assert(original.findCell(0, 0)->getValue().getNumber() == 4 && original.findCell(0, 2)->getValue().getNumber() == 9);
+    //Formulas are shared by copies, changes of one copy don't reach the other one
+    Tables formulaCopy(original);
+    formulaCopy.deleteCell(0, 0);
+    formulaCopy.setValue(1, 0, "3");
+    formulaCopy.addFormula(1, 1, "a2 + 1");
+    original.setValue(0, 0, "7");
+    original.updateInsideFormula();
+    assert(original.findCell(0, 1)->getValue().getNumber() == 14 && original.findCell(0, 2)->getValue().getNumber() == 15);
+    assert(original.findCell(1, 1) == nullptr && formulaCopy.findCell(0, 1) == nullptr);
+    formulaCopy.setValue(1, 0, "5");
+    formulaCopy.updateInsideFormula();
+    assert(formulaCopy.findCell(1, 1)->getValue().getNumber() == 6);
+
+    Tables indexedTest;
+    for (int i = 0; i < 20000; i++)
+        indexedTest.setValue(i, 0, "1");
+    indexedTest.addFormula(0, 1, "sum ( a1:a20000 )");
+    indexedTest.updateInsideFormula();
+    indexedTest.begin();
+    indexedTest.setValue(4, 0, "101");
+    indexedTest.commit();
+    assert(indexedTest.findCell(0, 1)->getValue().getNumber() == 20100);
+    indexedTest.begin();
+    indexedTest.setValue(6, 0, "1001");
+    indexedTest.rollback();
+    assert(indexedTest.findCell(0, 1)->getValue().getNumber() == 20100);
+    //Index changed inside a transaction must not be shared with a saved table
+    indexedTest.setValue(0, 0, "2");
+    indexedTest.updateInsideFormula();
+    assert(indexedTest.findCell(0, 1)->getValue().getNumber() == 20101);
+
+    Tables importTest;
+    importTest.importTable(std::string_view("\"3\",\"\",\"x\"\r\n\"\",\"\",\"\"\nFunction:\n\"\",\"a1 * 2\",\"\"\n"));
+    importTest.updateInsideFormula();
+    assert(importTest.findCell(0, 1)->getValue().getNumber() == 6);
+    assert(importTest.findCell(0, 2)->getValue().getString() == "x");
+    assert(importTest.findCell(1, 0) == nullptr);
+
+    Tables cyclicTest;
+    cyclicTest.importTable(std::string_view("\"\",\"\",\"2\"\nFunction:\n\"b1 + 1\",\"a1 + 1\",\"\"\n"));
+    bool cyclic = false;
+    try
+    {
+        cyclicTest.updateInsideFormula();
+    }
+    catch (const std::logic_error &ex)
+    {
+        cyclic = true;
+    }
+    assert(cyclic && cyclicTest.findCell(0, 0)->getValue().getType() == ValueType::ERROR);
+    cyclicTest.setValue(0, 2, "5");
+    cyclicTest.updateInsideFormula();
+    cyclicTest.printTable();
+    std::ofstream cyclicOut("testCyclic.csv", std::ios::trunc);
+    cyclicTest.exportTable(cyclicOut);
+    cyclicOut.close();
+    std::remove("testCyclic.csv");
+
+    std::ofstream snapshotOut("testSnapshot.bin", std::ios::trunc | std::ios::binary);
+    importTest.exportBinary(snapshotOut);
+    snapshotOut.close();
+    Tables snapshotTest;
+    snapshotTest.importBinary(std::string("testSnapshot.bin"));
+    std::remove("testSnapshot.bin");
+    assert(snapshotTest.findCell(0, 1)->getType() == CellType::FORMULA);
+    assert(snapshotTest.findCell(0, 1)->getValue().getNumber() == 6);
+    snapshotTest.setValue(0, 0, "4");
+    snapshotTest.updateInsideFormula();
+    assert(snapshotTest.findCell(0, 1)->getValue().getNumber() == 8);
+
+    //Snapshot ends with the last formula's instructions, its name "a1", depth of a stack and 0 dirty formulas
+    Tables corruptTest;
+    corruptTest.setValue(0, 0, "2");
+    corruptTest.addFormula(0, 1, "a1 + 1");
+    std::ofstream corruptOut("testCorrupt.bin", std::ios::trunc | std::ios::binary);
+    corruptTest.exportBinary(corruptOut);
+    corruptOut.close();
+    std::ifstream corruptIn("testCorrupt.bin", std::ios::binary);
+    std::stringstream corruptData;
+    corruptData << corruptIn.rdbuf();
+    corruptIn.close();
+    std::remove("testCorrupt.bin");
+    const std::string snapshot = corruptData.str();
+    const size_t instructionSize = 1 + 5 * sizeof(int32_t) + sizeof(double);
+    const size_t stackPos = snapshot.size() - 2 * sizeof(uint64_t);
+    const size_t codePos = stackPos - sizeof(uint64_t) - 2 - sizeof(uint64_t) - 3 * instructionSize;
+    std::string corrupt = snapshot;
+    corrupt[codePos + 2 * instructionSize] = (char)200;
+    bool rejected = false;
+    try
+    {
+        corruptTest.importBinary(std::string_view(corrupt));
+    }
+    catch (const std::logic_error &ex)
+    {
+        rejected = true;
+    }
+    assert(rejected);
+    rejected = false;
     try
     {
-        StringCell stringTest;
-        stringTest.function("sin");
+        corruptTest.importBinary(std::string_view(snapshot).substr(0, codePos));
     }
-    catch (const std::exception &ex)
+    catch (const std::logic_error &ex)
     {
-        exceptionThrown = true;
+        rejected = true;
     }
+    //Rejected snapshot doesn't change a table
+    assert(rejected);
+    corruptTest.setValue(0, 0, "50");
+    corruptTest.updateInsideFormula();
+    assert(corruptTest.findCell(0, 1)->getValue().getNumber() == 51);
+    corrupt = snapshot;
+    corrupt[codePos + 1 + 4 * sizeof(int32_t)] = 5;
+    rejected = false;
+    try
+    {
+        Tables().importBinary(std::string_view(corrupt));
+    }
+    catch (const std::logic_error &ex)
+    {
+        rejected = true;
+    }
+    assert(rejected);
+    corrupt = snapshot;
+    corrupt.replace(stackPos, sizeof(uint64_t), sizeof(uint64_t), '\0');
+    Tables stackTest;
+    stackTest.importBinary(std::string_view(corrupt));
+    stackTest.setValue(0, 0, "4");
+    stackTest.updateInsideFormula();
+    assert(stackTest.findCell(0, 1)->getValue().getNumber() == 5);
+
+    Tables registryTest;
+    registryTest.setValue(0, 0, "1");
+    registryTest.addFormula(0, 1, "a1 + 1");
+    registryTest.addFormula(0, 2, "b1 + 1");
+    registryTest.addFormula(0, 3, "a1 * 3");
+    registryTest.deleteCell(0, 1);
+    assert(registryTest.findCell(0, 2) == nullptr);
+    registryTest.addFormula(0, 1, "d1 + 1");
+    bool cycle = false;
+    try
+    {
+        registryTest.addFormula(0, 3, "b1 + 1");
+    }
+    catch (const std::logic_error &ex)
+    {
+        cycle = true;
+    }
+    assert(cycle && registryTest.findCell(0, 3)->getValue().getNumber() == 0);
+
+    double numbers[] = {3, -1, 4, 1, 5, 9, 2};
+    assert(sumKernel(numbers, 7) == 23 && minKernel(numbers, 7) == -1 && maxKernel(numbers, 7) == 9);
+
+    NumberColumn indexedColumn;
+    for (size_t i = 0; i < 300; i++)
+        indexedColumn.set(i, Value((double)i));
+    ColumnIndex indexTest(indexedColumn);
+    indexedColumn.set(150, Value(std::string("text")));
+    indexTest.update(150, indexedColumn);
+    Aggregate part = indexTest.query(10, 260, indexedColumn);
+    assert(part.count == 250 && part.sum == 135 * 251 - 150 && part.min == 10 && part.max == 260);
+    part = indexTest.query(10, 60, indexedColumn);
+    assert(part.count == 51 && part.sum == 1785 && part.min == 10 && part.max == 60);
+    indexedColumn.set(5000000, Value(7.0));
+    indexTest.update(5000000, indexedColumn);
+    part = indexTest.query(0, 6000000, indexedColumn);
+    assert(part.count == 300 && part.sum == 149 * 300 + 150 - 150 + 7 && part.max == 299 && part.min == 0);
 
-    assert(exceptionThrown);
+    NumberColumn columnTest;
+    for (size_t i = 0; i < 200; i++)
+        columnTest.set(i, Value((double)i - 100));
+    columnTest.set(64, Value(std::string("text")));
+    columnTest.set(65, Value::error("error"));
+    part = columnTest.aggregate(60, 130, true);
+    assert(part.count == 69 && part.errors == 1 && part.min == -40 && part.max == 30);
+    assert(part.sum == (-40 + 30) * 71 / 2 - (-36) - (-35));
+    assert(columnTest.isNumber(64) == false && columnTest.getNumber(66) == -34);
 
-    exceptionThrown = false;
+    NumberColumn sparseTest;
+    sparseTest.set(2000000, Value(5.0));
+    sparseTest.set(2000063, Value(-2.0));
+    sparseTest.set(10, Value::error("error"));
+    part = sparseTest.aggregate(0, 3000000, true);
+    assert(part.count == 2 && part.errors == 1 && part.sum == 3 && part.min == -2 && part.max == 5);
+    part = sparseTest.aggregate(11, 1999999, true);
+    assert(part.count == 0 && part.errors == 0 && part.sum == 0);
+    sparseTest.set(10, Value(std::string("text")));
+    assert(sparseTest.isNumber(10) == false && sparseTest.getNumber(5) == 0 && sparseTest.getNumber(2000063) == -2);
+
+    ColumnWidth widthTest;
+    widthTest.change(0, 7);
+    widthTest.change(0, 7);
+    widthTest.change(0, 2);
+    assert(widthTest.getWidth() == 7);
+    widthTest.change(7, 1);
+    assert(widthTest.getWidth() == 7);
+    widthTest.change(7, 0);
+    assert(widthTest.getWidth() == 2);
+    widthTest.change(0, 9);
+    assert(widthTest.getWidth() == 9);
+    widthTest.change(9, 0);
+    widthTest.change(2, 0);
+    widthTest.change(1, 0);
+    assert(widthTest.getWidth() == 0);
+
+    Tables rangeTest;
+    rangeTest.setValue(0, 0, "1");
+    rangeTest.setValue(1, 0, "text");
+    rangeTest.setValue(2, 0, "5");
+    rangeTest.addFormula(0, 1, "sum ( a1:a3 ) + count ( a1:a3 )");
+    assert(rangeTest.findCell(0, 1)->getValue().getNumber() == 8);
+    rangeTest.setValue(1, 0, "4");
+    rangeTest.updateInsideFormula();
+    assert(rangeTest.findCell(0, 1)->getValue().getNumber() == 13);
+    rangeTest.addFormula(0, 2, "b1 + 1");
+    bool rangeCycle = false;
     try
     {
-        NumCell numTest;
-        numTest.operation("/", "a", false);
+        rangeTest.addFormula(2, 0, "c1 * 2");
+    }
+    catch (const std::logic_error &ex)
+    {
+        rangeCycle = true;
     }
-    catch (const std::exception &ex)
+    assert(rangeCycle && rangeTest.findCell(2, 0)->getValue().getNumber() == 0);
+
+    Graph levelTest(3);
+    levelTest.addEdge(0, 1);
+    levelTest.addEdge(2, 1);
+    std::vector<std::vector<int>> levels = levelTest.levels();
+    assert(levels.size() == 2 && levels[0] == std::vector<int>({1}) && levels[1] == std::vector<int>({0, 2}));
+
+    Graph chainTest(1000000);
+    for (int i = 1; i < 1000000; i++)
+        chainTest.addEdge(i, i - 1);
+    assert(chainTest.isCyclic() == false);
+    assert(chainTest.topologicalSort().front() == 999999);
+    chainTest.addEdge(0, 999999);
+    assert(chainTest.isCyclic() == true);
+
+    setThreadCount(4);
+    Tables parallelTest;
+    for (int i = 0; i < 500; i++)
     {
-        exceptionThrown = true;
+        parallelTest.setValue(i, 0, std::to_string(i));
+        parallelTest.addFormula(i, 1, "a" + std::to_string(i + 1) + " * 2");
     }
-    assert(exceptionThrown);
+    parallelTest.updateInsideFormula();
+    for (int i = 0; i < 500; i++)
+        assert(parallelTest.findCell(i, 1)->getValue().getNumber() == i * 2);
+    assert(parallelTest.findCell(0, 1)->getFormula() == parallelTest.findCell(499, 1)->getFormula());
+    parallelTest.setValue(250, 0, "x");
+    parallelTest.updateInsideFormula();
+    assert(parallelTest.findCell(250, 1)->getValue().getString() == "xx");
+    assert(parallelTest.findCell(251, 1)->getValue().getNumber() == 502);
+    //Threads are reused by every call, nested call runs on its own thread
+    std::set<std::thread::id> usedThreads;
+    std::mutex usedLock;
+    std::atomic<size_t> processed(0);
+    for (int i = 0; i < 200; i++)
+        parallelFor(64, 4, [&](size_t begin, size_t end) {
+            parallelFor(end - begin, 1, [&](size_t from, size_t to) { processed += to - from; });
+            std::lock_guard<std::mutex> lock(usedLock);
+            usedThreads.insert(std::this_thread::get_id());
+        });
+    assert(processed == 200 * 64 && usedThreads.size() <= 4);
+    //Work of two grains uses two threads, even if more of them are allowed
+    setThreadCount(64);
+    usedThreads.clear();
+    for (int i = 0; i < 50; i++)
+        parallelFor(8, 4, [&](size_t, size_t) {
+            std::lock_guard<std::mutex> lock(usedLock);
+            usedThreads.insert(std::this_thread::get_id());
+        });
+    assert(usedThreads.size() <= 2);
+    bool tooMany = false;
+    try
+    {
+        setThreadCount(MAX_THREADS + 1);
+    }
+    catch (const std::logic_error &ex)
+    {
+        tooMany = true;
+    }
+    assert(tooMany && getThreadCount() == 64);
+    setThreadCount(0);
+    assert(cellName(9, 27) == "ab10");
+
+    Tables scriptTest;
+    std::istringstream script("a1 = 2\n\nformula b1 = a1 * 3\na1 = 4\n");
+    assert(Execute::runScript(script, scriptTest));
+    assert(scriptTest.findCell(0, 1)->getValue().getNumber() == 12);
+    std::istringstream failing("a1 = 1\nbogus command\nformula b1 = c5 + 1\nc1 = 7\n");
+    assert(!Execute::runScript(failing, scriptTest));
+    assert(scriptTest.findCell(0, 0)->getValue().getNumber() == 1 && scriptTest.findCell(0, 1) == nullptr && scriptTest.findCell(0, 2)->getValue().getNumber() == 7);
+    std::ofstream cyclicFile("examples/testCyclic.csv", std::ios::trunc);
+    cyclicFile << "\"\",\"\"\nFunction:\n\"b1 + 1\",\"a1 + 1\"\n";
+    cyclicFile.close();
+    std::istringstream cyclicScript("import testCyclic.csv\nc1 = 1\n");
+    assert(!Execute::runScript(cyclicScript, scriptTest));
+    std::remove("examples/testCyclic.csv");
+    assert(scriptTest.findCell(0, 0)->getValue().getType() == ValueType::ERROR && scriptTest.findCell(0, 2)->getValue().getNumber() == 1);
+    std::ofstream quietFile("examples/testQuiet.csv", std::ios::trunc);
+    quietFile << "\"7\",\"\"\nFunction:\n\"\",\"a1 + 1\"\n";
+    quietFile.close();
+    Tables quiet;
+    quiet.setValue(3, 3, "5");
+    Commands importCommand;
+    importCommand.setInput("import testQuiet.csv");
+    importCommand.checkCommand();
+    importCommand.checkSequence();
+    assert(Execute(importCommand, &quiet, false).executeCommand());
+    std::remove("examples/testQuiet.csv");
+    quiet.updateInsideFormula();
+    assert(quiet.findCell(3, 3) == nullptr && quiet.findCell(0, 1)->getValue().getNumber() == 8);
 
     std::cout << "EVERYTHING IS CORRECT!" << std::endl;
     return EXIT_SUCCESS;